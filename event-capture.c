@@ -0,0 +1,498 @@
+//
+//  File: %event-capture.c
+//  Summary: "Binary event records, and recording to and replaying from files"
+//  Section: ports
+//  Project: "Rebol 3 Interpreter and Run-time (Ren-C branch)"
+//  Homepage: https://github.com/metaeducation/ren-c/
+//
+//=////////////////////////////////////////////////////////////////////////=//
+//
+// Copyright 2023 Ren-C Open Source Contributors
+// REBOL is a trademark of REBOL Technologies
+//
+// See README.md and CREDITS.md for more information.
+//
+// Licensed under the Lesser GPL, Version 3.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://www.gnu.org/licenses/lgpl-3.0.html
+//
+//=////////////////////////////////////////////////////////////////////////=//
+//
+// See the BINARY EVENT RECORDS section of %reb-event.h for the format.
+//
+// Recording is done by the event port's queue: while a capture is attached,
+// every event that Enqueue_Event() adds is appended to a file mapped into
+// memory, so the cost per event is a store of 24 bytes.  The file is sized
+// for a maximum number of records up front, and is truncated to what was
+// written when the recording stops.
+//
+
+#include "sys-core.h"
+
+#include "reb-event.h"
+
+
+// Open-addressed (linear probing) table entry, for finding an eventee's
+// index without scanning the eventees.
+//
+typedef struct {
+    Node* node;  // nullptr if unused
+    uint32_t index;
+} Eventee_Entry;
+
+struct Reb_Event_Capture {
+    Event_File_Mapping file;
+    uint32_t limit;  // most records the file has room for
+    uint32_t count;
+    uint64_t missed;  // events after the file was full
+    int64_t start;  // monotonic nanoseconds when recording began
+
+    // Eventees seen so far.  The array keeps them alive for the GC (and is
+    // what the caller gets back), the hash table maps their nodes to their
+    // indices in it.  Indices count from `offset` in the array.
+    //
+    // For RECORD-EVENTS the array is in the port's STATE, so the GC marks
+    // it with the port.  (It holds the port itself, which would never be
+    // collected if the array were an API handle.)
+    //
+    Array(*) eventees;
+    REBLEN offset;
+    Eventee_Entry *entries;
+    uint32_t capacity;  // of entries, a power of 2 (or 0)
+    uint32_t num_entries;  // kept to at most half the capacity
+    bool scratch;  // entries are in `series`, see Encode_Events()
+    Binary(*) series;
+};
+
+
+inline static void Put_U16(Byte *bp, uint16_t u) {
+    bp[0] = cast(Byte, u);
+    bp[1] = cast(Byte, u >> 8);
+}
+
+inline static void Put_U32(Byte *bp, uint32_t u) {
+    Put_U16(bp, cast(uint16_t, u));
+    Put_U16(bp + 2, cast(uint16_t, u >> 16));
+}
+
+inline static void Put_U64(Byte *bp, uint64_t u) {
+    Put_U32(bp, cast(uint32_t, u));
+    Put_U32(bp + 4, cast(uint32_t, u >> 32));
+}
+
+inline static uint16_t Get_U16(const Byte *bp)
+  { return bp[0] | (bp[1] << 8); }
+
+inline static uint32_t Get_U32(const Byte *bp)
+  { return Get_U16(bp) | (cast(uint32_t, Get_U16(bp + 2)) << 16); }
+
+inline static uint64_t Get_U64(const Byte *bp)
+  { return Get_U32(bp) | (cast(uint64_t, Get_U32(bp + 4)) << 32); }
+
+
+//
+//  Encode_Event_Record: C
+//
+void Encode_Event_Record(
+    Byte *bp,
+    noquote(Cell(const*)) event,
+    int64_t time,
+    uint32_t eventee
+){
+    Put_U64(bp, time);
+    Put_U16(bp + 8, VAL_EVENT_TYPE(event));
+    bp[10] = VAL_EVENT_FLAGS(event);
+    bp[11] = VAL_EVENT_MODEL(event);
+    uint64_t data = VAL_EVENT_DATA(event);  // e.g. a TIME event's 64-bit CODE
+    Put_U32(bp + 12, cast(uint32_t, data));
+    Put_U32(bp + 16, eventee);
+    Put_U32(bp + 20, cast(uint32_t, data >> 32));
+}
+
+
+//
+//  Decode_Event_Record: C
+//
+// The eventee is looked up in `eventees` (a block, or nullptr).  Events whose
+// eventee isn't there go to `port` if given, so a capture can be replayed
+// into a port other than the one it was recorded from.
+//
+REBVAL *Decode_Event_Record(
+    REBVAL *out,
+    const Byte *bp,
+    const REBVAL *eventees,
+    const REBVAL *port
+){
+    uint16_t type = Get_U16(bp + 8);
+    Byte flags = bp[10];
+    Byte model = bp[11];
+    uint32_t index = Get_U32(bp + 16);
+
+    if (type == SYM_0 or type >= ALL_SYMS_MAX or model >= EVM_MAX)
+        fail ("Event record is corrupt (bad type or model)");
+
+    Node* node = nullptr;
+    if (model == EVM_PORT or model == EVM_OBJECT) {
+        Cell(const*) eventee = nullptr;
+        if (eventees and index != EVENT_EVENTEE_NONE) {
+            Cell(const*) tail;
+            Cell(const*) head = VAL_ARRAY_AT(&tail, eventees);
+            if (index < cast(uint32_t, tail - head))
+                eventee = head + index;
+        }
+
+        if (eventee and (IS_PORT(eventee) or IS_OBJECT(eventee))) {
+            model = IS_PORT(eventee) ? EVM_PORT : EVM_OBJECT;
+            node = CTX_VARLIST(VAL_CONTEXT(eventee));
+        }
+        else if (port) {
+            model = EVM_PORT;
+            node = CTX_VARLIST(VAL_CONTEXT(port));
+        }
+        else
+            fail ("Event record's eventee is not in the eventee table");
+    }
+
+    uint64_t data = Get_U32(bp + 12)
+        | (cast(uint64_t, Get_U32(bp + 20)) << 32);
+
+    return Init_Event(
+        out, cast(SymId, type), flags, model, node, cast(uintptr_t, data)
+    );
+}
+
+
+//
+//  Find_Eventee_Entry: C
+//
+// The entry for the node, or the unused entry where it would go.  There is
+// always an unused one, since the table is kept at most half full.
+//
+static Eventee_Entry *Find_Eventee_Entry(Event_Capture *c, Node* node)
+{
+    uint64_t hash = cast(uint64_t, cast(uintptr_t, node))
+        * 0x9E3779B97F4A7C15ull;  // Fibonacci hashing, spreads aligned nodes
+    uint32_t mask = c->capacity - 1;
+    uint32_t i = cast(uint32_t, hash >> 32) & mask;
+
+    while (c->entries[i].node != nullptr and c->entries[i].node != node)
+        i = (i + 1) & mask;
+    return &c->entries[i];
+}
+
+
+//
+//  Grow_Eventee_Table: C
+//
+// Double the table (or make the first one).  The entries of a capture are
+// malloc()'d, since it outlives any one native call.  Encode_Events() puts
+// them in an unmanaged series instead, which fail() frees if it's aborted.
+//
+static void Grow_Eventee_Table(Event_Capture *c)
+{
+    uint32_t capacity = c->capacity == 0 ? 16 : c->capacity * 2;
+    size_t size = sizeof(Eventee_Entry) * capacity;
+
+    Eventee_Entry *entries;
+    Binary(*) series = nullptr;
+    if (c->scratch) {
+        series = Make_Binary(size);
+        entries = cast(Eventee_Entry*, BIN_HEAD(series));
+    }
+    else {
+        entries = cast(Eventee_Entry*, malloc(size));
+        if (entries == nullptr)
+            fail (Error_No_Memory(size));
+    }
+    memset(entries, 0, size);
+
+    Eventee_Entry *old_entries = c->entries;
+    uint32_t old_capacity = c->capacity;
+    Binary(*) old_series = c->series;
+
+    c->entries = entries;
+    c->capacity = capacity;
+    c->series = series;
+
+    uint32_t i;
+    for (i = 0; i < old_capacity; ++i) {
+        if (old_entries[i].node)
+            *Find_Eventee_Entry(c, old_entries[i].node) = old_entries[i];
+    }
+
+    if (old_series)
+        Free_Unmanaged_Series(old_series);
+    else
+        free(old_entries);
+}
+
+
+//
+//  Add_Eventee_Entry: C
+//
+// Unless the node already has an entry, give it `index`.  Returns its entry.
+//
+static Eventee_Entry *Add_Eventee_Entry(
+    Event_Capture *c,
+    Node* node,
+    uint32_t index
+){
+    if ((c->num_entries + 1) * 2 > c->capacity)
+        Grow_Eventee_Table(c);
+
+    Eventee_Entry *e = Find_Eventee_Entry(c, node);
+    if (e->node == nullptr) {
+        e->node = node;
+        e->index = index;
+        ++c->num_entries;
+    }
+    return e;
+}
+
+
+//
+//  Eventee_Index: C
+//
+static uint32_t Eventee_Index(Event_Capture *c, noquote(Cell(const*)) event)
+{
+    Byte model = VAL_EVENT_MODEL(event);
+    if (model != EVM_PORT and model != EVM_OBJECT)
+        return EVENT_EVENTEE_NONE;
+
+    Node* node = VAL_EVENT_NODE(event);
+    if (c->capacity != 0) {
+        Eventee_Entry *e = Find_Eventee_Entry(c, node);
+        if (e->node)
+            return e->index;
+    }
+
+    REBLEN index = ARR_LEN(c->eventees) - c->offset;
+    if (index >= EVENT_EVENTEE_NONE)
+        fail ("Too many eventees for an event capture");
+
+    if (model == EVM_PORT)
+        Init_Port(Alloc_Tail_Array(c->eventees), CTX(node));
+    else
+        Init_Object(Alloc_Tail_Array(c->eventees), CTX(node));
+
+    return Add_Eventee_Entry(c, node, cast(uint32_t, index))->index;
+}
+
+
+//
+//  Init_Eventee_Table: C
+//
+static void Init_Eventee_Table(
+    Event_Capture *c,
+    Array(*) eventees,
+    REBLEN offset,
+    bool scratch
+){
+    c->eventees = eventees;
+    c->offset = offset;
+    c->entries = nullptr;
+    c->capacity = 0;
+    c->num_entries = 0;
+    c->scratch = scratch;
+    c->series = nullptr;
+}
+
+
+//
+//  Capture_Event: C
+//
+// Called by Enqueue_Event() for ports that are recording.
+//
+void Capture_Event(Event_Capture *c, const REBVAL *event)
+{
+    if (c->count == c->limit) {
+        ++c->missed;
+        return;
+    }
+
+    Byte *bp = c->file.base + EVENT_CAPTURE_HEADER_SIZE
+        + cast(size_t, c->count) * EVENT_RECORD_SIZE;
+
+    Encode_Event_Record(
+        bp,
+        event,
+        Delta_Nanoseconds(c->start),
+        Eventee_Index(c, event)
+    );
+    ++c->count;
+}
+
+
+//
+//  Start_Event_Capture: C
+//
+// Returns nullptr if the file can't be created and mapped.  Eventees are
+// appended to `eventees`, whose indices the records then refer to.
+//
+Event_Capture *Start_Event_Capture(
+    const char *path,
+    uint32_t limit,
+    Array(*) eventees
+){
+    Event_Capture *c = cast(Event_Capture*, malloc(sizeof(Event_Capture)));
+    if (c == nullptr)
+        fail (Error_No_Memory(sizeof(Event_Capture)));
+
+    size_t size = EVENT_CAPTURE_HEADER_SIZE
+        + cast(size_t, limit) * EVENT_RECORD_SIZE;
+    if (not Map_Event_File(&c->file, path, size, true)) {
+        free(c);
+        return nullptr;
+    }
+
+    Byte *bp = c->file.base;
+    memcpy(bp, EVENT_CAPTURE_MAGIC, 4);
+    Put_U16(bp + 4, EVENT_CAPTURE_VERSION);
+    Put_U16(bp + 6, EVENT_RECORD_SIZE);
+    Put_U32(bp + 8, 0);
+    Put_U32(bp + 12, 0);
+
+    c->limit = limit;
+    c->count = 0;
+    c->missed = 0;
+    c->start = Monotonic_Nanoseconds();
+
+    Init_Eventee_Table(c, eventees, ARR_LEN(eventees), false);
+    return c;
+}
+
+
+//
+//  Finish_Event_Capture: C
+//
+// Write the record count into the header, truncate the file to the records
+// that were written, and free the capture.  Returns the OS error code if
+// the truncation failed (the capture is freed either way).
+//
+int Finish_Event_Capture(Event_Capture *c)
+{
+    Put_U32(c->file.base + 8, c->count);
+    int error = Unmap_Event_File(
+        &c->file,
+        EVENT_CAPTURE_HEADER_SIZE + cast(size_t, c->count) * EVENT_RECORD_SIZE
+    );
+    free(c->entries);
+    free(c);
+    return error;
+}
+
+
+//
+//  Free_Event_Capture: C
+//
+// For a port that is garbage collected while still recording.  This is run
+// from the GC's sweep, so it only writes the record count into the header
+// and unmaps and closes the file.  The file isn't truncated, but readers go
+// by the count.
+//
+void Free_Event_Capture(Event_Capture *c)
+{
+    Put_U32(c->file.base + 8, c->count);
+    Unmap_Event_File(&c->file, c->file.size);
+    free(c->entries);
+    free(c);
+}
+
+
+//
+//  Check_Event_Capture_Header: C
+//
+// Returns the number of records, after checking they are all in the data.
+//
+uint32_t Check_Event_Capture_Header(const Byte *bp, size_t size)
+{
+    if (
+        size < EVENT_CAPTURE_HEADER_SIZE
+        or memcmp(bp, EVENT_CAPTURE_MAGIC, 4) != 0
+    ){
+        fail ("Not an event capture (no REVT header)");
+    }
+
+    if (Get_U16(bp + 4) != EVENT_CAPTURE_VERSION)
+        fail ("Unsupported event capture version");
+
+    if (Get_U16(bp + 6) != EVENT_RECORD_SIZE)
+        fail ("Event capture has the wrong record size");
+
+    uint32_t count = Get_U32(bp + 8);
+    if (
+        (size - EVENT_CAPTURE_HEADER_SIZE) / EVENT_RECORD_SIZE
+        < cast(size_t, count)
+    ){
+        fail ("Event capture is truncated");
+    }
+    return count;
+}
+
+
+//
+//  Event_Record_Time: C
+//
+int64_t Event_Record_Time(const Byte *bp)
+{
+    return cast(int64_t, Get_U64(bp));
+}
+
+
+//
+//  Encode_Events: C
+//
+// Make a capture (header and records, all with time 0) for a block of
+// events in memory.  The records' eventee indices refer to the `eventees`
+// block from its position.  Eventees already in it keep their indices (so
+// a table can be reused across calls), and new ones are appended.
+//
+REBVAL *Encode_Events(const REBVAL *events, REBVAL *eventees)
+{
+    Cell(const*) tail;
+    Cell(const*) head = VAL_ARRAY_AT(&tail, events);
+    REBLEN n = tail - head;
+
+    Cell(const*) item;
+    for (item = head; item != tail; ++item) {
+        if (not IS_EVENT(item))
+            fail (Error_Bad_Value(item));
+    }
+
+    VAL_ARRAY_ENSURE_MUTABLE(eventees);  // fail now, not partway
+
+    REBLEN size = EVENT_CAPTURE_HEADER_SIZE + n * EVENT_RECORD_SIZE;
+    REBVAL *binary = rebValue("make binary!", rebI(size));
+    Binary(*) bin = VAL_BINARY_ENSURE_MUTABLE(binary);
+    TERM_BIN_LEN(bin, size);
+
+    Byte *bp = BIN_HEAD(bin);
+    memcpy(bp, EVENT_CAPTURE_MAGIC, 4);
+    Put_U16(bp + 4, EVENT_CAPTURE_VERSION);
+    Put_U16(bp + 6, EVENT_RECORD_SIZE);
+    Put_U32(bp + 8, n);
+    Put_U32(bp + 12, 0);
+    bp += EVENT_CAPTURE_HEADER_SIZE;
+
+    Event_Capture c;  // only used for its eventee table
+    Init_Eventee_Table(
+        &c, VAL_ARRAY_KNOWN_MUTABLE(eventees), VAL_INDEX(eventees), true
+    );
+
+    Cell(const*) eventees_tail;
+    Cell(const*) eventee = VAL_ARRAY_AT(&eventees_tail, eventees);
+    uint32_t index;
+    for (index = 0; eventee != eventees_tail; ++eventee, ++index) {
+        if (IS_PORT(eventee) or IS_OBJECT(eventee))
+            Add_Eventee_Entry(&c, CTX_VARLIST(VAL_CONTEXT(eventee)), index);
+    }
+
+    for (item = head; item != tail; ++item, bp += EVENT_RECORD_SIZE)
+        Encode_Event_Record(bp, item, 0, Eventee_Index(&c, item));
+
+    if (c.series)
+        Free_Unmanaged_Series(c.series);
+    return binary;
+}
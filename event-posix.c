@@ -23,6 +23,12 @@
 // This implements what's needed by WAIT in order to yield to the OS event
 // loop for a certain period of time, with the ability to be interrupted.
 //
+// The yield is also cut short when a registered readiness source's file
+// descriptor becomes readable.  Linux uses an epoll set that mirrors the
+// registrations; other POSIX systems (or a Linux where epoll_create1() is
+// unavailable) build a select() set from the registered descriptors, which
+// with nothing registered is the historical sleep with no descriptors.
+//
 
 #if !defined( __cplusplus) && TO_LINUX
     // See feature_test_macros(7)
@@ -35,28 +41,82 @@
 #include <string.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <time.h>
 #include <sys/time.h>
+#include <sys/select.h>
 #include <sys/wait.h>
 #include <errno.h>
+#include <fcntl.h>
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if TO_LINUX
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <sys/timerfd.h>
+#endif
 
 #include "sys-core.h"
 
+#include "reb-event.h"
+
+
+#define MAX_READY_PER_WAKE 32  // epoll_wait() batch size
+
+static Event_Source **Sources = nullptr;  // registered readiness sources
+static REBLEN Num_Sources = 0;
+static REBLEN Sources_Capacity = 0;
+
+#if TO_LINUX
+    static int Epoll_Fd = -1;  // -1 means use the select() fallback
+
+    // The batch Wait_Epoll() is dispatching.  It's static rather than on the
+    // stack so Unregister_Event_Source() can null out a source's entries
+    // (and a callback that fails can't leave it pointing at a dead frame).
+    //
+    static struct epoll_event Ready[MAX_READY_PER_WAKE];
+    static int Num_Ready = 0;
+#endif
+
+static bool Force_Select = false;  // see Use_Wait_Backend()
+
+
+//
+//  Real_Monotonic_Nanoseconds: C
+//
+// CLOCK_MONOTONIC is serviced through the vDSO on Linux (and the equivalent
+// commpage on macOS), so reading it is a function call and not a syscall.
+// That makes it cheap enough to sample on hot paths.
+//
+int64_t Real_Monotonic_Nanoseconds(void)
+{
+  #if defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return cast(int64_t, ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  #endif
+
+    // !!! Wall clock fallback for systems without a monotonic clock.  This
+    // is subject to steps from NTP or the user setting the time.
+    //
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return cast(int64_t, tv.tv_sec) * 1000000000
+        + cast(int64_t, tv.tv_usec) * 1000;
+}
+
+
 //
 //  Delta_Time: C
 //
 // Return time difference in microseconds. If base = 0, then
 // return the counter. If base != 0, compute the time difference.
 //
-// NOTE: This needs to be precise, but many OSes do not
-// provide a precise time sampling method. So, if the target
-// posix OS does, add the ifdef code in here.
-//
 int64_t Delta_Time(int64_t base)
 {
-    struct timeval tv;
-    gettimeofday(&tv,0);
-
-    int64_t time = cast(int64_t, tv.tv_sec * 1000000) + tv.tv_usec;
+    int64_t time = Monotonic_Nanoseconds() / 1000;
     if (base == 0)
         return time;
 
@@ -67,36 +127,638 @@ int64_t Delta_Time(int64_t base)
 //
 //  Startup_Events: C
 //
-// Currently there is no special startup event code for POSIX.
+// On Linux this creates the epoll set used by WAIT to block on registered
+// readiness sources.  If that fails, the select() path is used instead.
 //
 void Startup_Events(void)
 {
+  #if TO_LINUX
+    assert(Epoll_Fd == -1);
+    Epoll_Fd = epoll_create1(EPOLL_CLOEXEC);  // may be -1, that's okay
+  #endif
 }
 
 
 //
-//  Wait_Milliseconds_Interrupted: C
+//  Shutdown_Events: C
 //
-// !!! This said "Wait for an event, or a timeout (in milliseconds)".  This
-// makes it sound like the select() statement could be interrupted by something
-// other than a timeout, even though it's passing in all 0s for the file
-// descriptors to wait on...is that just Ctrl-C?
+// Sources are owned by whoever registered them, so this only drops the list.
 //
-bool Wait_Milliseconds_Interrupted(
-    unsigned int millisec  // the MAX_WAIT_MS is 64 in WAIT, between polls
-){
+void Shutdown_Events(void)
+{
+  #if TO_LINUX
+    if (Epoll_Fd != -1) {
+        close(Epoll_Fd);
+        Epoll_Fd = -1;
+    }
+  #endif
+
+    free(Sources);
+    Sources = nullptr;
+    Num_Sources = 0;
+    Sources_Capacity = 0;
+}
+
+
+//
+//  Register_Event_Source: C
+//
+// Add a file descriptor that should wake WAIT when it becomes readable.  The
+// Event_Source must stay at the same address until it is unregistered.
+//
+bool Register_Event_Source(Event_Source *source)
+{
+    assert(source->fd >= 0 and source->on_ready != nullptr);
+
+    source->index = NOT_FOUND;  // so unregistering after a failure is a no-op
+
+    if (Num_Sources == Sources_Capacity) {
+        REBLEN capacity = Sources_Capacity == 0 ? 8 : Sources_Capacity * 2;
+        Event_Source **grown = cast(Event_Source**,
+            realloc(Sources, sizeof(Event_Source*) * capacity)
+        );
+        if (grown == nullptr)
+            return false;
+        Sources = grown;
+        Sources_Capacity = capacity;
+    }
+
+    bool use_select = true;
+
+  #if TO_LINUX
+    if (Epoll_Fd != -1) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = source;
+        if (epoll_ctl(Epoll_Fd, EPOLL_CTL_ADD, source->fd, &ev) != 0)
+            return false;
+        use_select = false;
+    }
+  #endif
+
+    if (use_select and source->fd >= FD_SETSIZE)  // can't go in an fd_set
+        return false;
+
+    source->index = Num_Sources;
+    Sources[Num_Sources] = source;
+    ++Num_Sources;
+    return true;
+}
+
+
+//
+//  Unregister_Event_Source: C
+//
+// Must be called before closing the source's descriptor, on a source that
+// Register_Event_Source() was called on (whether or not that succeeded).  It
+// is legal for a source to unregister itself, or any other source, from
+// inside its on_ready callback.
+//
+void Unregister_Event_Source(Event_Source *source)
+{
+    REBLEN i = source->index;
+    if (i >= Num_Sources or Sources[i] != source)
+        return;  // not registered (e.g. registration failed)
+
+    Sources[i] = Sources[Num_Sources - 1];  // order doesn't matter
+    Sources[i]->index = i;
+    --Num_Sources;
+    source->index = NOT_FOUND;
+
+  #if TO_LINUX
+    if (Epoll_Fd != -1)
+        epoll_ctl(Epoll_Fd, EPOLL_CTL_DEL, source->fd, nullptr);
+
+    int r;  // the source may be freed next, so don't dispatch to it
+    for (r = 0; r < Num_Ready; ++r) {
+        if (Ready[r].data.ptr == source)
+            Ready[r].data.ptr = nullptr;
+    }
+  #endif
+}
+
+
+//
+//  Open_Event_Wakeup: C
+//
+bool Open_Event_Wakeup(Event_Wakeup *w)
+{
+  #if TO_LINUX
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd != -1) {
+        w->read_fd = fd;
+        w->write_fd = fd;
+        return true;
+    }
+  #endif
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        w->read_fd = -1;
+        w->write_fd = -1;
+        return false;
+    }
+
+    int i;
+    for (i = 0; i < 2; ++i) {
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+    }
+    w->read_fd = fds[0];
+    w->write_fd = fds[1];
+    return true;
+}
+
+
+//
+//  Signal_Event_Wakeup: C
+//
+// Callable from any thread.  Doesn't touch interpreter state.
+//
+void Signal_Event_Wakeup(Event_Wakeup *w)
+{
+    if (w->write_fd == -1)
+        return;
+
+    uint64_t one = 1;  // an eventfd needs exactly 8 bytes, a pipe any
+    size_t size = (w->read_fd == w->write_fd) ? sizeof(one) : 1;
+    if (write(w->write_fd, &one, size) < 0) {
+        // EAGAIN means a pipe is full, so it's already readable.  Anything
+        // else can't be reported from a foreign thread.
+    }
+}
+
+
+//
+//  Clear_Event_Wakeup: C
+//
+void Clear_Event_Wakeup(Event_Wakeup *w)
+{
+    if (w->read_fd == -1)
+        return;
+
+    char buf[64];
+    while (read(w->read_fd, buf, sizeof(buf)) > 0)
+        continue;  // eventfd reads all at once, a pipe may need several
+}
+
+
+//
+//  Close_Event_Wakeup: C
+//
+void Close_Event_Wakeup(Event_Wakeup *w)
+{
+    if (w->read_fd != -1)
+        close(w->read_fd);
+    if (w->write_fd != -1 and w->write_fd != w->read_fd)
+        close(w->write_fd);
+    w->read_fd = -1;
+    w->write_fd = -1;
+}
+
+
+#if TO_LINUX
+
+//
+//  Wait_Epoll: C
+//
+static enum Reb_Wait_Result Wait_Epoll(unsigned int millisec)
+{
+    Num_Ready = 0;  // e.g. a callback failed out of the last dispatch
+
+    int n = epoll_wait(
+        Epoll_Fd, Ready, MAX_READY_PER_WAKE, cast(int, millisec)
+    );
+    if (n < 0) {
+        if (errno == EINTR)  // e.g. Ctrl-C interrupting timer on WAIT
+            return WAIT_INTERRUPTED;
+
+        rebFail_OS (errno);  // some other error
+    }
+
+    if (n == 0)
+        return WAIT_TIMED_OUT;
+
+    // A callback may unregister (and free) other sources that are later in
+    // this batch.  Unregister_Event_Source() nulls their entries, so that's
+    // an O(1) check here.  (Callbacks don't re-enter WAIT, so the batch
+    // can't be overwritten while it's being walked.)
+    //
+    Num_Ready = n;
+
+    int i;
+    for (i = 0; i < n; ++i) {
+        Event_Source *source = cast(Event_Source*, Ready[i].data.ptr);
+        if (source == nullptr)
+            continue;  // unregistered by an earlier callback in this batch
+
+        source->on_ready(source);
+    }
+    Num_Ready = 0;
+    return WAIT_SOURCE_READY;
+}
+
+#endif
+
+
+//
+//  Wait_Select: C
+//
+static enum Reb_Wait_Result Wait_Select(unsigned int millisec)
+{
     struct timeval tv;
+    tv.tv_sec = millisec / 1000;
+    tv.tv_usec = (millisec % 1000) * 1000;
 
-    tv.tv_sec = 0;
-    tv.tv_usec = millisec * 1000;
+    fd_set readfds;
+    FD_ZERO(&readfds);
 
-    int result = select(0, 0, 0, 0, &tv);
+    int max_fd = -1;
+    REBLEN i;
+    for (i = 0; i < Num_Sources; ++i) {
+        if (Sources[i]->fd >= FD_SETSIZE)  // only registered due to epoll
+            continue;
+        FD_SET(Sources[i]->fd, &readfds);
+        if (Sources[i]->fd > max_fd)
+            max_fd = Sources[i]->fd;
+    }
+
+    int result = select(max_fd + 1, &readfds, 0, 0, &tv);
     if (result < 0) {
         if (errno == EINTR)  // e.g. Ctrl-C interrupting timer on WAIT
-            return true;
+            return WAIT_INTERRUPTED;
 
         rebFail_OS (errno);  // some other error
     }
 
+    if (result == 0)
+        return WAIT_TIMED_OUT;
+
+    // Walk backwards, so a callback unregistering its own source (which
+    // swaps the last source into its position) doesn't cause any skipping.
+    // Clearing each descriptor as it's dispatched keeps an already-called
+    // source from being called again if an unregistration moves it lower.
+    //
+    for (i = Num_Sources; i != 0; --i) {
+        if (i > Num_Sources)
+            continue;  // callback unregistered more than one source
+        Event_Source *source = Sources[i - 1];
+        if (source->fd < FD_SETSIZE and FD_ISSET(source->fd, &readfds)) {
+            FD_CLR(source->fd, &readfds);
+            source->on_ready(source);
+        }
+    }
+    return WAIT_SOURCE_READY;
+}
+
+
+//
+//  Wait_Milliseconds_Interrupted: C
+//
+// Yield to the OS for up to `millisec`.  Returns early if a signal arrives
+// (e.g. Ctrl-C) or if any registered readiness source becomes readable, in
+// which case the ready sources' callbacks have been run before returning.
+//
+enum Reb_Wait_Result Wait_Milliseconds_Interrupted(
+    unsigned int millisec  // at most INT_MAX (WAIT's MAX_BLOCK_MS)
+){
+  #if TO_LINUX
+    if (Epoll_Fd != -1 and not Force_Select)
+        return Wait_Epoll(millisec);
+  #endif
+
+    return Wait_Select(millisec);
+}
+
+
+//
+//  Have_Event_Sources: C
+//
+bool Have_Event_Sources(void)
+{
+    return Num_Sources != 0;
+}
+
+
+//
+//  Poll_Event_Sources: C
+//
+// Run the callbacks of whichever registered sources are ready, without
+// blocking.  Returns true if any were.
+//
+bool Poll_Event_Sources(void)
+{
+    if (Num_Sources == 0)
+        return false;
+
+    return Wait_Milliseconds_Interrupted(0) == WAIT_SOURCE_READY;
+}
+
+
+//
+//  Wait_Backend_Name: C
+//
+const char *Wait_Backend_Name(void)
+{
+  #if TO_LINUX
+    if (Epoll_Fd != -1 and not Force_Select)
+        return "epoll";
+  #endif
+
+    return "select";
+}
+
+
+//
+//  Use_Wait_Backend: C
+//
+// Switch between backends at runtime, e.g. to compare them.  Registrations
+// are mirrored into the epoll set even while select() is in use, so either
+// direction of switching is immediate.
+//
+bool Use_Wait_Backend(const char *name)
+{
+    if (0 == strcmp(name, "select")) {
+        Force_Select = true;
+        return true;
+    }
+
+  #if TO_LINUX
+    if (0 == strcmp(name, "epoll") and Epoll_Fd != -1) {
+        Force_Select = false;
+        return true;
+    }
+  #endif
+
     return false;
 }
+
+
+//
+//  Process_Cpu_Nanoseconds: C
+//
+// CPU time consumed by all threads of the process, user and system.
+//
+int64_t Process_Cpu_Nanoseconds(void)
+{
+  #if defined(CLOCK_PROCESS_CPUTIME_ID)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0)
+        return cast(int64_t, ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  #endif
+
+    return cast(int64_t, clock()) * (1000000000 / CLOCKS_PER_SEC);
+}
+
+
+#if TO_LINUX
+
+struct Reb_Event_Timer {
+    Event_Source source;  // the timerfd
+    Event_Queue *queue;
+    uint64_t unqueued;  // expirations whose event the queue refused
+};
+
+
+//
+//  Event_Timer_Expired: C
+//
+// Readiness source callback.  Reading a timerfd gives the number of times
+// it expired since the last read, and resets that count.  So if the queue
+// refuses the event (a full queue under EVQ_OVERFLOW_BLOCK), the count is
+// kept here and added to the next event's, instead of being lost.  (A
+// one-shot timer has no next event, so it shouldn't be used with BLOCK.)
+//
+static void Event_Timer_Expired(Event_Source *source)
+{
+    Event_Timer *timer = cast(Event_Timer*, source->context);
+
+    uint64_t expirations;
+    if (read(source->fd, &expirations, sizeof(expirations)) != 8)
+        return;  // EAGAIN, e.g. the timer was re-armed since it was ready
+
+    expirations += timer->unqueued;
+    if (expirations < timer->unqueued or expirations > UINTPTR_MAX)
+        expirations = UINTPTR_MAX;  // saturate
+    timer->unqueued = 0;
+
+    Event_Queue *q = timer->queue;
+    DECLARE_LOCAL (event);
+    Init_Event(
+        event,
+        SYM_TIME,
+        EVF_MASK_NONE,
+        EVM_PORT,
+        CTX_VARLIST(q->port),
+        cast(uintptr_t, expirations)
+    );
+    if (not Enqueue_Event(q, event))  // subject to the port's overflow policy
+        timer->unqueued = expirations;
+}
+
+#endif
+
+
+//
+//  Arm_Event_Timer: C
+//
+Event_Timer *Arm_Event_Timer(Event_Queue *q, int64_t delay, int64_t period)
+{
+  #if TO_LINUX
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd == -1)
+        return nullptr;
+
+    if (delay <= 0)
+        delay = 1;  // a zero it_value would disarm the timer
+
+    struct itimerspec spec;
+    spec.it_value.tv_sec = delay / 1000000000;
+    spec.it_value.tv_nsec = delay % 1000000000;
+    spec.it_interval.tv_sec = period / 1000000000;
+    spec.it_interval.tv_nsec = period % 1000000000;
+
+    Event_Timer *timer = cast(Event_Timer*, malloc(sizeof(Event_Timer)));
+    if (timer == nullptr) {
+        close(fd);
+        return nullptr;
+    }
+    timer->queue = q;
+    timer->unqueued = 0;
+    timer->source.fd = fd;
+    timer->source.on_ready = &Event_Timer_Expired;
+    timer->source.context = timer;
+
+    if (
+        not Register_Event_Source(&timer->source)
+        or timerfd_settime(fd, 0, &spec, nullptr) == -1
+    ){
+        Disarm_Event_Timer(timer);
+        return nullptr;
+    }
+    return timer;
+  #else
+    UNUSED(q);
+    UNUSED(delay);
+    UNUSED(period);
+    return nullptr;
+  #endif
+}
+
+
+//
+//  Disarm_Event_Timer: C
+//
+void Disarm_Event_Timer(Event_Timer *timer)
+{
+  #if TO_LINUX
+    Unregister_Event_Source(&timer->source);  // tolerates not registered
+    close(timer->source.fd);
+    free(timer);
+  #else
+    UNUSED(timer);
+  #endif
+}
+
+
+//
+//  Map_Event_File: C
+//
+bool Map_Event_File(
+    Event_File_Mapping *m,
+    const char *path,
+    size_t size,
+    bool writable
+){
+    int fd;
+    if (writable) {
+        fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+        if (fd == -1)
+            return false;
+        if (ftruncate(fd, size) == -1) {
+            close(fd);
+            return false;
+        }
+    }
+    else {
+        fd = open(path, O_RDONLY);
+        if (fd == -1)
+            return false;
+
+        struct stat st;
+        if (fstat(fd, &st) == -1) {
+            close(fd);
+            return false;
+        }
+        size = st.st_size;
+    }
+
+    void *base = nullptr;
+    if (size != 0) {  // mmap() of zero bytes is an error
+        base = mmap(
+            nullptr,
+            size,
+            writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+            MAP_SHARED,
+            fd,
+            0
+        );
+        if (base == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+    }
+
+    m->base = cast(Byte*, base);
+    m->size = size;
+    m->handle = fd;
+    m->writable = writable;
+    return true;
+}
+
+
+//
+//  Unmap_Event_File: C
+//
+// The mapping is always unmapped and closed.  Returns errno if shrinking a
+// writable file to `keep` bytes failed, else 0.
+//
+int Unmap_Event_File(Event_File_Mapping *m, size_t keep)
+{
+    if (m->base)
+        munmap(m->base, m->size);
+
+    int error = 0;
+    if (m->writable and keep != m->size and ftruncate(m->handle, keep) == -1)
+        error = errno;
+
+    close(m->handle);
+    m->base = nullptr;
+    m->size = 0;
+    m->handle = -1;
+    return error;
+}
+
+
+typedef struct {
+    Event_Post_Queue *pq;
+    Posted_Event event;
+    unsigned int millisec;
+} Delayed_Post;
+
+static void *Delayed_Post_Thread(void *p)
+{
+    Delayed_Post *d = cast(Delayed_Post*, p);
+
+    struct timespec ts;
+    ts.tv_sec = d->millisec / 1000;
+    ts.tv_nsec = (d->millisec % 1000) * 1000000;
+    while (nanosleep(&ts, &ts) != 0 and errno == EINTR)
+        continue;
+
+    Post_Event(d->pq, &d->event);  // fails if the port was closed meanwhile
+    Release_Event_Post_Queue(d->pq);
+    free(d);
+    return nullptr;
+}
+
+
+//
+//  Post_Event_Later: C
+//
+// Post from a short-lived helper thread after a delay.  This exists so that
+// the wakeup path of WAIT can be measured without an external producer.
+// The helper holds a reference on the post queue, so closing the port
+// before it posts is safe (the event is just not delivered).
+//
+bool Post_Event_Later(
+    Event_Post_Queue *pq,
+    const Posted_Event *event,
+    unsigned int millisec
+){
+    Delayed_Post *d = cast(Delayed_Post*, malloc(sizeof(Delayed_Post)));
+    if (d == nullptr)
+        return false;
+
+    d->pq = pq;
+    d->event = *event;
+    d->millisec = millisec;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    Retain_Event_Post_Queue(pq);
+
+    pthread_t thread;
+    int result = pthread_create(&thread, &attr, &Delayed_Post_Thread, d);
+    pthread_attr_destroy(&attr);
+
+    if (result != 0) {
+        Release_Event_Post_Queue(pq);
+        free(d);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,481 @@
+//
+//  File: %event-timeouts.c
+//  Summary: "Hierarchical timing wheel for SET-TIMEOUT"
+//  Section: ports
+//  Project: "Rebol 3 Interpreter and Run-time (Ren-C branch)"
+//  Homepage: https://github.com/metaeducation/ren-c/
+//
+//=////////////////////////////////////////////////////////////////////////=//
+//
+// Copyright 2023 Ren-C Open Source Contributors
+// REBOL is a trademark of REBOL Technologies
+//
+// See README.md and CREDITS.md for more information.
+//
+// Licensed under the Lesser GPL, Version 3.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://www.gnu.org/licenses/lgpl-3.0.html
+//
+//=////////////////////////////////////////////////////////////////////////=//
+//
+// See the TIMEOUTS section of %reb-event.h for the layout of the wheel.
+//
+// Timeouts live in one array of slots, which is grown by doubling and never
+// shrinks.  Links between them are slot + 1 (so 0 ends a list), rather than
+// pointers, so growing the array doesn't invalidate anything.  Each pending
+// timeout is on two doubly-linked lists: the wheel bucket it's filed in,
+// and its port's timeouts (so closing the port can cancel them all).  Free
+// slots are kept on a singly-linked list through `next`.
+//
+// Each level has a bit per bucket saying whether it's nonempty.  Finding
+// the next bucket to come due is then a rotate and a count of trailing
+// zeros per level, and running the wheel forward skips straight over ticks
+// where nothing happens--so a virtual clock jumping ahead by hours costs no
+// more than one that moves a millisecond.
+//
+
+#include "sys-core.h"
+
+#include "reb-event.h"
+
+
+#define WHEEL_BITS 6  // log2 of EVENT_WHEEL_BUCKETS
+#define WHEEL_MASK (EVENT_WHEEL_BUCKETS - 1)
+#define WHEEL_SPAN (cast(int64_t, 1) << (WHEEL_BITS * EVENT_WHEEL_LEVELS))
+
+#define TIMEOUT_SLOT_BITS 20  // see EVENT_TIMEOUTS_MAX
+
+#define TIMEOUTS_CHUNK 256  // initial number of slots
+
+typedef struct {
+    Event_Queue *queue;  // port to queue the event into, null if slot free
+    int64_t due;  // nanoseconds, on the Monotonic_Nanoseconds() clock
+    int64_t period;  // nanoseconds, 0 for one-shot
+
+    uint32_t prev;  // in the wheel bucket
+    uint32_t next;  // ...or in the free list, if the slot is free
+    uint32_t prev_of_queue;
+    uint32_t next_of_queue;
+
+    uint32_t generation;  // changed when the slot is freed, never 0
+    Byte level;  // bucket this is filed in, for unlinking
+    Byte bucket;
+} Event_Timeout;
+
+static struct {
+    Event_Timeout *slots;
+    uint32_t capacity;
+    uint32_t used;  // slots below this are pending or on the free list
+    uint32_t free;  // slot + 1 of the first free one, 0 if none
+    REBLEN pending;
+
+    int64_t now;  // tick the wheel has been run up to
+    uint64_t occupied[EVENT_WHEEL_LEVELS];  // bit per nonempty bucket
+    uint32_t buckets[EVENT_WHEEL_LEVELS][EVENT_WHEEL_BUCKETS];  // slot + 1
+} Wheel;
+
+
+inline static int64_t Due_Tick(int64_t due)  // rounded up, so never early
+  { return (due + EVENT_WHEEL_TICK - 1) / EVENT_WHEEL_TICK; }
+
+inline static uint64_t Timeout_Id(uint32_t slot) {  // 52 bits, positive
+    uint64_t generation = Wheel.slots[slot].generation;
+    return (generation << TIMEOUT_SLOT_BITS) | slot;
+}
+
+
+//
+//  Lowest_Set_Bit: C
+//
+static REBLEN Lowest_Set_Bit(uint64_t bits)  // bits must not be 0
+{
+  #if defined(__GNUC__)  // includes clang
+    return __builtin_ctzll(bits);
+  #else
+    REBLEN n = 0;
+    while (not (bits & 1)) {
+        bits >>= 1;
+        ++n;
+    }
+    return n;
+  #endif
+}
+
+
+//
+//  File_Timeout: C
+//
+// Put a timeout into the bucket for its due tick, relative to where the
+// wheel is now.  A timeout that is already due goes into the level 0 bucket
+// for the current tick (which only happens while that tick is being run).
+//
+static void File_Timeout(uint32_t slot)
+{
+    Event_Timeout *t = &Wheel.slots[slot];
+
+    int64_t tick = Due_Tick(t->due);
+    int64_t delta = tick - Wheel.now;
+    if (delta < 0) {
+        delta = 0;
+        tick = Wheel.now;
+    }
+    else if (delta >= WHEEL_SPAN)
+        tick = Wheel.now + WHEEL_SPAN - 1;  // filed again when it comes up
+
+    REBLEN level = 0;
+    while (
+        level < EVENT_WHEEL_LEVELS - 1
+        and delta >= (cast(int64_t, 1) << (WHEEL_BITS * (level + 1)))
+    ){
+        ++level;
+    }
+    REBLEN bucket = cast(REBLEN, tick >> (WHEEL_BITS * level)) & WHEEL_MASK;
+
+    uint32_t *head = &Wheel.buckets[level][bucket];
+    t->level = cast(Byte, level);
+    t->bucket = cast(Byte, bucket);
+    t->prev = 0;
+    t->next = *head;
+    if (*head)
+        Wheel.slots[*head - 1].prev = slot + 1;
+    *head = slot + 1;
+    Wheel.occupied[level] |= cast(uint64_t, 1) << bucket;
+}
+
+
+//
+//  Unfile_Timeout: C
+//
+static void Unfile_Timeout(uint32_t slot)
+{
+    Event_Timeout *t = &Wheel.slots[slot];
+
+    uint32_t *head = &Wheel.buckets[t->level][t->bucket];
+    if (t->prev)
+        Wheel.slots[t->prev - 1].next = t->next;
+    else
+        *head = t->next;
+    if (t->next)
+        Wheel.slots[t->next - 1].prev = t->prev;
+
+    if (*head == 0)
+        Wheel.occupied[t->level] &= ~(cast(uint64_t, 1) << t->bucket);
+}
+
+
+//
+//  Free_Timeout: C
+//
+// Take a timeout that has been unfiled off its port's list, and free its
+// slot.  The new generation makes the old id stale.  It's 32 bits, so a
+// stale id can only match again after the slot is reused 4 billion times.
+//
+static void Free_Timeout(uint32_t slot)
+{
+    Event_Timeout *t = &Wheel.slots[slot];
+    Event_Queue *q = t->queue;
+
+    if (t->prev_of_queue)
+        Wheel.slots[t->prev_of_queue - 1].next_of_queue = t->next_of_queue;
+    else
+        q->timeouts = t->next_of_queue;
+    if (t->next_of_queue)
+        Wheel.slots[t->next_of_queue - 1].prev_of_queue = t->prev_of_queue;
+
+    t->queue = nullptr;
+    ++t->generation;
+    if (t->generation == 0)
+        t->generation = 1;
+
+    t->next = Wheel.free;
+    Wheel.free = slot + 1;
+    --Wheel.pending;
+}
+
+
+//
+//  Set_Event_Timeout: C
+//
+uint64_t Set_Event_Timeout(Event_Queue *q, int64_t delay, int64_t period)
+{
+    if (Wheel.free == 0 and Wheel.used == Wheel.capacity) {
+        if (Wheel.capacity == EVENT_TIMEOUTS_MAX)
+            return 0;
+
+        uint32_t capacity = Wheel.capacity
+            ? Wheel.capacity * 2
+            : TIMEOUTS_CHUNK;
+        Event_Timeout *slots = cast(Event_Timeout*,
+            realloc(Wheel.slots, sizeof(Event_Timeout) * capacity)
+        );
+        if (slots == nullptr)
+            return 0;
+
+        Wheel.slots = slots;
+        Wheel.capacity = capacity;
+    }
+
+    uint32_t slot;
+    if (Wheel.free) {
+        slot = Wheel.free - 1;
+        Wheel.free = Wheel.slots[slot].next;
+    }
+    else {
+        slot = Wheel.used++;
+        Wheel.slots[slot].generation = 1;
+    }
+
+    // An empty wheel can start from anywhere, so bring it to the present
+    // (which may even be behind it, after switching off a virtual clock).
+    //
+    int64_t now = Monotonic_Nanoseconds();
+    if (Wheel.pending == 0)
+        Wheel.now = now / EVENT_WHEEL_TICK;
+    ++Wheel.pending;
+
+    Event_Timeout *t = &Wheel.slots[slot];
+    t->queue = q;
+    t->due = now + delay;
+    t->period = period;
+    if (Due_Tick(t->due) <= Wheel.now)  // the tick the wheel is on has run
+        t->due = (Wheel.now + 1) * EVENT_WHEEL_TICK;
+
+    t->prev_of_queue = 0;
+    t->next_of_queue = q->timeouts;
+    if (q->timeouts)
+        Wheel.slots[q->timeouts - 1].prev_of_queue = slot + 1;
+    q->timeouts = slot + 1;
+
+    File_Timeout(slot);
+    return Timeout_Id(slot);
+}
+
+
+//
+//  Cancel_Event_Timeout: C
+//
+bool Cancel_Event_Timeout(uint64_t id)
+{
+    uint32_t slot = cast(uint32_t, id & (EVENT_TIMEOUTS_MAX - 1));
+    if (slot >= Wheel.used)
+        return false;
+
+    if (
+        Wheel.slots[slot].queue == nullptr
+        or Timeout_Id(slot) != id
+    ){
+        return false;  // fired (if one-shot) or cancelled already
+    }
+
+    Unfile_Timeout(slot);
+    Free_Timeout(slot);
+    return true;
+}
+
+
+//
+//  Cancel_Event_Timeouts: C
+//
+// Called when an event port is closed or garbage collected.
+//
+void Cancel_Event_Timeouts(Event_Queue *q)
+{
+    if (Wheel.slots == nullptr) {  // after Shutdown_Event_Timeouts()
+        q->timeouts = 0;
+        return;
+    }
+
+    while (q->timeouts) {
+        uint32_t slot = q->timeouts - 1;
+        Unfile_Timeout(slot);
+        Free_Timeout(slot);  // advances q->timeouts
+    }
+}
+
+
+//
+//  Next_Wheel_Tick: C
+//
+// The soonest tick at which the wheel has something to do: fire a level 0
+// bucket, or file a higher level's bucket into the levels below.
+//
+static int64_t Next_Wheel_Tick(void)
+{
+    int64_t next = INT64_MAX;
+
+    REBLEN level;
+    for (level = 0; level < EVENT_WHEEL_LEVELS; ++level) {
+        uint64_t occupied = Wheel.occupied[level];
+        if (occupied == 0)
+            continue;
+
+        // Rotate so bit 0 is the bucket after the one the wheel is on.
+        //
+        REBLEN shift = WHEEL_BITS * level;
+        int64_t base = Wheel.now >> shift;
+        REBLEN n = cast(REBLEN, base + 1) & WHEEL_MASK;
+        if (n != 0)
+            occupied = (occupied >> n) | (occupied << (EVENT_WHEEL_BUCKETS - n));
+
+        int64_t tick = (base + 1 + Lowest_Set_Bit(occupied)) << shift;
+        if (tick < next)
+            next = tick;
+    }
+
+    return next;
+}
+
+
+//
+//  Next_Event_Timeout: C
+//
+// When the next timeout fires it will be this or later (it's exact when the
+// next timeout is in level 0, else it's when the wheel has to look again).
+//
+int64_t Next_Event_Timeout(void)
+{
+    int64_t tick = Next_Wheel_Tick();
+    if (tick == INT64_MAX)
+        return INT64_MAX;
+    return tick * EVENT_WHEEL_TICK;
+}
+
+
+//
+//  Next_Event_Timeout_Of_Queue: C
+//
+// When the soonest of one port's timeouts fires, or INT64_MAX if it has
+// none.  This walks the port's own list, so it costs as many steps as the
+// port has timeouts (unlike Next_Event_Timeout(), which is for all ports).
+//
+int64_t Next_Event_Timeout_Of_Queue(Event_Queue *q)
+{
+    int64_t next = INT64_MAX;
+
+    uint32_t link;
+    for (link = q->timeouts; link != 0; ) {
+        Event_Timeout *t = &Wheel.slots[link - 1];
+        int64_t fires = Due_Tick(t->due) * EVENT_WHEEL_TICK;
+        if (fires < next)
+            next = fires;
+        link = t->next_of_queue;
+    }
+
+    return next;
+}
+
+
+//
+//  Turn_Wheel: C
+//
+// Advance the wheel by one tick.  First any higher level buckets that start
+// at this tick are filed again into the levels below, then the level 0
+// bucket is fired.  Periodic timeouts are filed again for their next time
+// (no sooner than the next tick, if the period is shorter than one).
+//
+static REBLEN Turn_Wheel(void)
+{
+    int64_t tick = ++Wheel.now;
+
+    REBLEN level;
+    for (level = EVENT_WHEEL_LEVELS - 1; level > 0; --level) {
+        REBLEN shift = WHEEL_BITS * level;
+        if (tick & ((cast(int64_t, 1) << shift) - 1))
+            continue;  // not the start of a bucket at this level
+
+        REBLEN bucket = cast(REBLEN, tick >> shift) & WHEEL_MASK;
+        uint32_t list = Wheel.buckets[level][bucket];
+        Wheel.buckets[level][bucket] = 0;
+        Wheel.occupied[level] &= ~(cast(uint64_t, 1) << bucket);
+
+        while (list) {
+            uint32_t slot = list - 1;
+            list = Wheel.slots[slot].next;
+            File_Timeout(slot);
+        }
+    }
+
+    // Each timeout is taken off the bucket before its event is queued, so
+    // the wheel is consistent if queueing fails.
+    //
+    REBLEN fired = 0;
+    REBLEN bucket = cast(REBLEN, tick) & WHEEL_MASK;
+    while (Wheel.buckets[0][bucket]) {
+        uint32_t slot = Wheel.buckets[0][bucket] - 1;
+        Event_Timeout *t = &Wheel.slots[slot];
+        Event_Queue *q = t->queue;
+        uint64_t id = Timeout_Id(slot);
+
+        Unfile_Timeout(slot);
+        if (t->period == 0)
+            Free_Timeout(slot);
+        else {
+            t->due += t->period;
+            if (Due_Tick(t->due) <= tick)
+                t->due = (tick + 1) * EVENT_WHEEL_TICK;
+            File_Timeout(slot);
+        }
+
+        DECLARE_LOCAL (event);
+        Init_Event(
+            event,
+            SYM_TIME,
+            EVF_MASK_NONE,
+            EVM_PORT,
+            CTX_VARLIST(q->port),
+            cast(uintptr_t, id)  // !!! truncated on 32-bit platforms
+        );
+        Enqueue_Event(q, event);  // subject to the port's overflow policy
+        ++fired;
+    }
+
+    return fired;
+}
+
+
+//
+//  Run_Event_Timeouts: C
+//
+// Fire everything due by `now` (nanoseconds, as from Monotonic_Nanoseconds).
+// If the clock is behind the wheel, nothing happens until it catches up.
+//
+REBLEN Run_Event_Timeouts(int64_t now)
+{
+    int64_t target = now / EVENT_WHEEL_TICK;
+
+    REBLEN fired = 0;
+    while (Wheel.now < target) {
+        int64_t next = Next_Wheel_Tick();
+        if (next > target) {
+            Wheel.now = target;  // buckets passed over are all empty
+            break;
+        }
+        Wheel.now = next - 1;
+        fired += Turn_Wheel();
+    }
+    return fired;
+}
+
+
+//
+//  Pending_Event_Timeouts: C
+//
+REBLEN Pending_Event_Timeouts(void)
+{
+    return Wheel.pending;
+}
+
+
+//
+//  Shutdown_Event_Timeouts: C
+//
+// Ports still holding timeouts may be garbage collected after this, which
+// is why Cancel_Event_Timeouts() checks for the slots being gone.
+//
+void Shutdown_Event_Timeouts(void)
+{
+    free(Wheel.slots);
+    memset(&Wheel, 0, sizeof(Wheel));
+}
@@ -0,0 +1,175 @@
+//
+//  File: %event-trace.c
+//  Summary: "Trace recorder for the event subsystem"
+//  Section: ports
+//  Project: "Rebol 3 Interpreter and Run-time (Ren-C branch)"
+//  Homepage: https://github.com/metaeducation/ren-c/
+//
+//=////////////////////////////////////////////////////////////////////////=//
+//
+// Copyright 2023 Ren-C Open Source Contributors
+// REBOL is a trademark of REBOL Technologies
+//
+// See README.md and CREDITS.md for more information.
+//
+// Licensed under the Lesser GPL, Version 3.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://www.gnu.org/licenses/lgpl-3.0.html
+//
+//=////////////////////////////////////////////////////////////////////////=//
+//
+// Only compiled in with DEBUG_EVENT_TRACE (see the TRACING section of
+// %reb-event.h).
+//
+// A writer claims a position with an atomic add, fills in the record at
+// that position modulo the ring size, and then publishes it by storing the
+// position + 1 in the record's sequence.  Readers only trust a record whose
+// sequence matches the position they expect, so a record that is being
+// written (or was lapped by a later writer) is skipped instead of torn.
+//
+
+#include "sys-core.h"
+
+#include "reb-event.h"
+
+#if DEBUG_EVENT_TRACE
+
+#define EVENT_TRACE_RECORDS 16384  // power of 2
+
+typedef struct {
+    uintptr_t sequence;  // atomic, position + 1 once the record is written
+    int64_t start;  // monotonic nanoseconds
+    int64_t duration;  // nanoseconds, -1 for an instant
+    uintptr_t arg;
+    enum Reb_Event_Trace_Kind kind;
+} Event_Trace_Record;
+
+static Event_Trace_Record Trace_Ring[EVENT_TRACE_RECORDS];
+static uintptr_t Trace_Position;  // atomic, next position to claim
+
+// Names shown in the trace viewer, indexed by enum Reb_Event_Trace_Kind.
+//
+static const char *Event_Trace_Names[EVENT_TRACE_MAX] = {
+    "wait-iteration",
+    "poll",
+    "sleep",
+    "wake",
+    "enqueue",
+    "dequeue",
+    "clear",
+    "make-event"
+};
+
+
+//
+//  Trace_Event: C
+//
+// Record an instant (start is 0) or a span from `start` until now.
+//
+void Trace_Event(enum Reb_Event_Trace_Kind kind, int64_t start, uintptr_t arg)
+{
+    int64_t now = Real_Monotonic_Nanoseconds();
+
+    uintptr_t pos = Atomic_Fetch_Add(&Trace_Position, 1);
+    Event_Trace_Record *r = &Trace_Ring[pos & (EVENT_TRACE_RECORDS - 1)];
+
+    Atomic_Store(&r->sequence, 0);  // unpublish while rewriting
+    r->kind = kind;
+    r->arg = arg;
+    if (start == 0) {
+        r->start = now;
+        r->duration = -1;
+    }
+    else {
+        r->start = start;
+        r->duration = now - start;
+    }
+    Atomic_Store(&r->sequence, pos + 1);
+}
+
+
+//
+//  Append_Trace_Microseconds: C
+//
+// Chrome's trace format measures in microseconds, with fractions allowed.
+//
+static void Append_Trace_Microseconds(REB_MOLD *mo, int64_t nanoseconds)
+{
+    char buf[32];
+    snprintf(
+        buf, sizeof(buf), "%lld.%03d",
+        cast(long long, nanoseconds / 1000),
+        cast(int, nanoseconds % 1000)
+    );
+    Append_Ascii(mo->series, buf);
+}
+
+
+//
+//  Mold_Event_Trace: C
+//
+// Emit the recorded events, oldest first, as a JSON array of complete ("X")
+// and instant ("i") trace events.
+//
+void Mold_Event_Trace(REB_MOLD *mo)
+{
+    uintptr_t end = Atomic_Load(&Trace_Position);
+    uintptr_t pos = end > EVENT_TRACE_RECORDS ? end - EVENT_TRACE_RECORDS : 0;
+
+    Append_Ascii(mo->series, "[");
+
+    bool first = true;
+    for (; pos != end; ++pos) {
+        Event_Trace_Record *r = &Trace_Ring[pos & (EVENT_TRACE_RECORDS - 1)];
+        if (Atomic_Load(&r->sequence) != pos + 1)
+            continue;  // being written, or overwritten by a newer record
+
+        Event_Trace_Record copy = *r;
+        if (Atomic_Load(&r->sequence) != pos + 1)
+            continue;  // rewritten while it was being copied
+
+        if (not first)
+            Append_Ascii(mo->series, ",");
+        first = false;
+
+        Append_Ascii(mo->series, "\n{\"name\":\"");
+        Append_Ascii(mo->series, Event_Trace_Names[copy.kind]);
+        Append_Ascii(mo->series, "\",\"cat\":\"event\",\"pid\":1,\"tid\":1");
+
+        Append_Ascii(mo->series, ",\"ts\":");
+        Append_Trace_Microseconds(mo, copy.start);
+
+        if (copy.duration < 0)
+            Append_Ascii(mo->series, ",\"ph\":\"i\",\"s\":\"t\"");
+        else {
+            Append_Ascii(mo->series, ",\"ph\":\"X\",\"dur\":");
+            Append_Trace_Microseconds(mo, copy.duration);
+        }
+
+        char buf[32];
+        snprintf(
+            buf, sizeof(buf), ",\"args\":{\"arg\":%llu}}",
+            cast(unsigned long long, copy.arg)
+        );
+        Append_Ascii(mo->series, buf);
+    }
+
+    Append_Ascii(mo->series, "\n]\n");
+}
+
+
+//
+//  Clear_Event_Trace: C
+//
+// Forget everything recorded so far.
+//
+void Clear_Event_Trace(void)
+{
+    uintptr_t pos;
+    for (pos = 0; pos < EVENT_TRACE_RECORDS; ++pos)
+        Atomic_Store(&Trace_Ring[pos].sequence, 0);
+}
+
+#endif
@@ -33,6 +33,33 @@
 
 #include "sys-core.h"
 
+#include "reb-event.h"
+
+
+//
+//  Real_Monotonic_Nanoseconds: C
+//
+// The performance counter is monotonic, and its frequency is fixed at boot,
+// so the frequency is only queried once.  Splitting into whole seconds and
+// a remainder avoids overflowing 64 bits when scaling up to nanoseconds.
+//
+int64_t Real_Monotonic_Nanoseconds(void)
+{
+    static LONGLONG freq = 0;
+    if (freq == 0) {
+        LARGE_INTEGER f;
+        if (not QueryPerformanceFrequency(&f))
+            rebJumps("panic {Missing high performance timer}");
+        freq = f.QuadPart;
+    }
+
+    LARGE_INTEGER time;
+    QueryPerformanceCounter(&time);
+
+    return (time.QuadPart / freq) * 1000000000
+        + ((time.QuadPart % freq) * 1000000000) / freq;
+}
+
 
 //
 //  Delta_Time: C
@@ -40,21 +67,13 @@
 // Return time difference in microseconds. If base = 0, then
 // return the counter. If base != 0, compute the time difference.
 //
-// Note: Requires high performance timer.
-//      Q: If not found, use timeGetTime() instead ?!
-//
 int64_t Delta_Time(int64_t base)
 {
-    LARGE_INTEGER time;
-    if (not QueryPerformanceCounter(&time))
-        rebJumps("panic {Missing high performance timer}");
+    int64_t time = Monotonic_Nanoseconds() / 1000;
+    if (base == 0)
+        return time;
 
-    if (base == 0) return time.QuadPart; // counter (may not be time)
-
-    LARGE_INTEGER freq;
-    QueryPerformanceFrequency(&freq);
-
-    return ((time.QuadPart - base) * 1000) / (freq.QuadPart / 1000);
+    return time - base;
 }
 
 
@@ -71,6 +90,250 @@ void Startup_Events(void)
 }
 
 
+//
+//  Shutdown_Events: C
+//
+void Shutdown_Events(void)
+{
+}
+
+
+//
+//  Register_Event_Source: C
+//
+// !!! Readiness sources are file descriptors, which the message pump used
+// by Wait_Milliseconds_Interrupted() can't wait on.  Callers must cope with
+// the registration failing (e.g. by relying on device polling instead).
+//
+bool Register_Event_Source(Event_Source *source)
+{
+    UNUSED(source);
+    return false;
+}
+
+
+//
+//  Unregister_Event_Source: C
+//
+void Unregister_Event_Source(Event_Source *source)
+{
+    UNUSED(source);
+}
+
+
+//
+//  Open_Event_Wakeup: C
+//
+// !!! See Register_Event_Source().  Events posted from other threads are
+// moved into their port when it is next acted on, but don't wake WAIT.
+//
+bool Open_Event_Wakeup(Event_Wakeup *w)
+{
+    w->read_fd = -1;
+    w->write_fd = -1;
+    return false;
+}
+
+
+//
+//  Signal_Event_Wakeup: C
+//
+void Signal_Event_Wakeup(Event_Wakeup *w)
+{
+    UNUSED(w);
+}
+
+
+//
+//  Clear_Event_Wakeup: C
+//
+void Clear_Event_Wakeup(Event_Wakeup *w)
+{
+    UNUSED(w);
+}
+
+
+//
+//  Close_Event_Wakeup: C
+//
+void Close_Event_Wakeup(Event_Wakeup *w)
+{
+    UNUSED(w);
+}
+
+
+//
+//  Have_Event_Sources: C
+//
+bool Have_Event_Sources(void)
+{
+    return false;  // see Register_Event_Source()
+}
+
+
+//
+//  Poll_Event_Sources: C
+//
+// !!! See Register_Event_Source(), there are never any sources to poll.
+//
+bool Poll_Event_Sources(void)
+{
+    return false;
+}
+
+
+//
+//  Wait_Backend_Name: C
+//
+const char *Wait_Backend_Name(void)
+{
+    return "message-pump";
+}
+
+
+//
+//  Use_Wait_Backend: C
+//
+bool Use_Wait_Backend(const char *name)
+{
+    return 0 == strcmp(name, "message-pump");
+}
+
+
+//
+//  Process_Cpu_Nanoseconds: C
+//
+// CPU time consumed by all threads of the process, user and kernel.
+//
+int64_t Process_Cpu_Nanoseconds(void)
+{
+    FILETIME creation, exit, kernel, user;
+    if (not GetProcessTimes(
+        GetCurrentProcess(), &creation, &exit, &kernel, &user
+    )){
+        rebFail_OS (GetLastError());
+    }
+
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+
+    return cast(int64_t, k.QuadPart + u.QuadPart) * 100;  // 100ns units
+}
+
+
+//
+//  Arm_Event_Timer: C
+//
+// !!! Timer ports are not implemented on Windows yet (a waitable timer would
+// need WAIT to use MsgWaitForMultipleObjects() instead of GetMessage()).
+//
+Event_Timer *Arm_Event_Timer(Event_Queue *q, int64_t delay, int64_t period)
+{
+    UNUSED(q);
+    UNUSED(delay);
+    UNUSED(period);
+    return nullptr;
+}
+
+
+//
+//  Disarm_Event_Timer: C
+//
+void Disarm_Event_Timer(Event_Timer *timer)
+{
+    UNUSED(timer);
+}
+
+
+//
+//  Map_Event_File: C
+//
+// !!! Capture files are not implemented on Windows yet (this would be
+// CreateFileMapping() and MapViewOfFile()).
+//
+bool Map_Event_File(
+    Event_File_Mapping *m,
+    const char *path,
+    size_t size,
+    bool writable
+){
+    UNUSED(path);
+    UNUSED(size);
+    UNUSED(writable);
+
+    m->base = nullptr;
+    m->size = 0;
+    m->handle = -1;
+    m->writable = false;
+    return false;
+}
+
+
+//
+//  Unmap_Event_File: C
+//
+int Unmap_Event_File(Event_File_Mapping *m, size_t keep)
+{
+    UNUSED(m);
+    UNUSED(keep);
+    return 0;
+}
+
+
+typedef struct {
+    Event_Post_Queue *pq;
+    Posted_Event event;
+    unsigned int millisec;
+} Delayed_Post;
+
+static DWORD WINAPI Delayed_Post_Thread(LPVOID p)
+{
+    Delayed_Post *d = cast(Delayed_Post*, p);
+    Sleep(d->millisec);
+    Post_Event(d->pq, &d->event);  // fails if the port was closed meanwhile
+    Release_Event_Post_Queue(d->pq);
+    free(d);
+    return 0;
+}
+
+
+//
+//  Post_Event_Later: C
+//
+// Post from a short-lived helper thread after a delay.  This exists so that
+// the wakeup path of WAIT can be measured without an external producer.
+// The helper holds a reference on the post queue, so closing the port
+// before it posts is safe (the event is just not delivered).
+//
+bool Post_Event_Later(
+    Event_Post_Queue *pq,
+    const Posted_Event *event,
+    unsigned int millisec
+){
+    Delayed_Post *d = cast(Delayed_Post*, malloc(sizeof(Delayed_Post)));
+    if (d == nullptr)
+        return false;
+
+    d->pq = pq;
+    d->event = *event;
+    d->millisec = millisec;
+
+    Retain_Event_Post_Queue(pq);
+
+    HANDLE thread = CreateThread(nullptr, 0, &Delayed_Post_Thread, d, 0, nullptr);
+    if (thread == nullptr) {
+        Release_Event_Post_Queue(pq);
+        free(d);
+        return false;
+    }
+    CloseHandle(thread);  // detach
+    return true;
+}
+
+
 //
 //  Wait_Milliseconds_Interrupted: C
 //
@@ -80,8 +343,8 @@ void Startup_Events(void)
 // that does not apply, so it's just being a good citizen by yielding the
 // CPU rather than keeping it in a busy wait during WAIT.
 //
-bool Wait_Milliseconds_Interrupted(
-    unsigned int millisec  // the MAX_WAIT_MS is 64 in WAIT, between polls
+enum Reb_Wait_Result Wait_Milliseconds_Interrupted(
+    unsigned int millisec  // at most INT_MAX (WAIT's MAX_BLOCK_MS)
 ){
     // Set timer (we assume this is very fast)
     //
@@ -123,7 +386,7 @@ bool Wait_Milliseconds_Interrupted(
     if (msg.message == WM_TIMER) {
         assert(timer_id == msg.wParam);
         KillTimer(hwnd, timer_id);
-        return false;  // not interrupted, waited the full time
+        return WAIT_TIMED_OUT;  // not interrupted, waited the full time
     }
 
     // R3-Alpha did a trick here and did a peek to see if the timer message
@@ -137,7 +400,7 @@ bool Wait_Milliseconds_Interrupted(
         if (msg.message == WM_TIMER) {
             assert(timer_id == msg.wParam);
             KillTimer(hwnd, timer_id);
-            return false;
+            return WAIT_TIMED_OUT;
         }
     }
 
@@ -145,5 +408,5 @@ bool Wait_Milliseconds_Interrupted(
     // do...so assume it means we want to run the polling loop.
     //
     KillTimer(hwnd, timer_id);
-    return true;  // interrupted by some GUI event or otherwise
+    return WAIT_INTERRUPTED;  // by some GUI event or otherwise
 }
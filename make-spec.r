@@ -6,6 +6,10 @@ includes: [%prep/extensions/event]
 
 depends: compose [
     %event/t-event.c
+    %event/p-event.c
+    %event/event-trace.c  ; empty unless built with DEBUG_EVENT_TRACE=1
+    %event/event-capture.c
+    %event/event-timeouts.c
 
     (switch system-config/os-base [
         'Windows [
@@ -27,4 +31,10 @@ libraries: maybe switch system-config/os-base [
         ;
         [%user32]
     ]
+    'Linux [
+        ;
+        ; Needed for pthread_create() on glibc older than 2.34
+        ;
+        [%pthread]
+    ]
 ]
@@ -30,84 +30,1338 @@
 
 #include "reb-event.h"
 
-extern void Startup_Events(void);
-extern void Shutdown_Events(void);
 
-extern bool Wait_Milliseconds_Interrupted(unsigned int millisec);
+Symbol(const*) S_Event(void) {
+    return Canon(EVENT_X);
+}
+
+
+//
+//  startup*: native [  ; Note: DO NOT EXPORT!
+//
+//  {Make the EVENT! datatype work with GENERIC actions, comparison ops, etc}
+//
+//      return: <none>
+//  ]
+//
+DECLARE_NATIVE(startup_p)
+{
+    EVENT_INCLUDE_PARAMS_OF_STARTUP_P;
+
+    // !!! See notes on Hook_Datatype for this poor-man's substitute for a
+    // coherent design of an extensible object system (as per Lisp's CLOS)
+    //
+    // !!! EVENT has a specific desire to use *all* of the bits in the cell.
+    // However, extension types generally do not have this option.  So we
+    // make a special exemption and allow REB_EVENT to take one of the
+    // builtin type bytes, so it can use the EXTRA() for more data.  This
+    // may or may not be worth it for this case...but it's a demonstration of
+    // a degree of freedom that we have.
+
+    const enum Reb_Kind k = REB_EVENT;
+    Builtin_Type_Hooks[k][IDX_SYMBOL_HOOK] = cast(CFUNC*, &S_Event);
+    Builtin_Type_Hooks[k][IDX_GENERIC_HOOK] = cast(CFUNC*, &T_Event);
+    Builtin_Type_Hooks[k][IDX_COMPARE_HOOK] = cast(CFUNC*, &CT_Event);
+    Builtin_Type_Hooks[k][IDX_MAKE_HOOK] = cast(CFUNC*, &MAKE_Event);
+    Builtin_Type_Hooks[k][IDX_TO_HOOK] = cast(CFUNC*, &TO_Event);
+    Builtin_Type_Hooks[k][IDX_MOLD_HOOK] = cast(CFUNC*, &MF_Event);
+
+    Startup_Event_Flags();  // shared blocks for reading FLAGS
+    Startup_Events();  // initialize other event stuff
+
+    return NONE;
+}
+
+
+//
+//  shutdown*: native [  ; Note: DO NOT EXPORT!
+//
+//  {Remove behaviors for EVENT! added by REGISTER-EVENT-HOOKS}
+//
+//      return: <none>
+//  ]
+//
+DECLARE_NATIVE(shutdown_p)
+{
+    EVENT_INCLUDE_PARAMS_OF_SHUTDOWN_P;
+
+    // !!! See notes in register-event-hooks for why we reach below the
+    // normal custom type machinery to pack an event into a single cell
+    //
+    const enum Reb_Kind k = REB_EVENT;
+    Builtin_Type_Hooks[k][IDX_GENERIC_HOOK] = cast(CFUNC*, &T_Unhooked);
+    Builtin_Type_Hooks[k][IDX_COMPARE_HOOK] = cast(CFUNC*, &CT_Unhooked);
+    Builtin_Type_Hooks[k][IDX_MAKE_HOOK] = cast(CFUNC*, &MAKE_Unhooked);
+    Builtin_Type_Hooks[k][IDX_TO_HOOK] = cast(CFUNC*, &TO_Unhooked);
+    Builtin_Type_Hooks[k][IDX_MOLD_HOOK] = cast(CFUNC*, &MF_Unhooked);
+
+    Shutdown_Event_Timeouts();
+    Shutdown_Events();  // e.g. close the epoll descriptor on Linux
+    Shutdown_Event_Flags();
+
+    return NONE;
+}
+
+
+//
+//  get-event-actor-handle: native [
+//
+//  {Retrieve handle to the native actor for event ports}
+//
+//      return: [handle!]
+//  ]
+//
+DECLARE_NATIVE(get_event_actor_handle)
+{
+    EVENT_INCLUDE_PARAMS_OF_GET_EVENT_ACTOR_HANDLE;
+
+    Make_Port_Actor_Handle(OUT, &Event_Actor);
+    return OUT;
+}
+
+
+//
+//  export configure-event-port: native [
+//
+//  {Adjust the queueing behavior of an event port}
+//
+//      return: [port!]
+//      port [port!]
+//      /limit "Most events that will be queued at once (up to 65535)"
+//          [integer!]
+//      /overflow "When full: BLOCK, DROP-OLDEST, DROP-NEWEST, or COALESCE"
+//          [word!]
+//      /coalesce "Merge motion events into a pending one from the same source"
+//          [logic!]
+//      /latency "Time how long events wait, for `reflect port 'stats`"
+//          [logic!]
+//  ]
+//
+DECLARE_NATIVE(configure_event_port)
+//
+// BLOCK makes INSERT/APPEND raise an error when the queue is full, so the
+// producer can back off and retry after the consumer has taken events.
+// The other policies keep the queue at the limit, and count what they shed
+// in the counters reported by `reflect port 'stats`.
+//
+// Turning /LATENCY on resets its histogram.  A coalesced event keeps the
+// time of the event it was merged into, since that's how long the state it
+// carries has been waiting.
+{
+    EVENT_INCLUDE_PARAMS_OF_CONFIGURE_EVENT_PORT;
+
+    Event_Queue *queue = Event_Queue_Of_Port(ARG(port));
+
+    if (REF(limit)) {
+        REBINT limit = VAL_INT32(ARG(limit));
+        if (limit < 1 or limit > EVENTS_LIMIT)
+            fail (Error_Out_Of_Range(ARG(limit)));
+        queue->limit = limit;
+    }
+
+    if (REF(overflow))
+        queue->overflow = Event_Overflow_From_Word(ARG(overflow));
+
+    if (REF(coalesce))
+        queue->coalesce_motion = VAL_LOGIC(ARG(coalesce));
+
+    if (REF(latency))
+        Track_Event_Latency(queue, VAL_LOGIC(ARG(latency)));
+
+    return COPY(ARG(port));
+}
+
+
+//
+//  export find-events: native [
+//
+//  {Find queued events in an event port, without taking them}
+//
+//      return: "First match, or BLOCK! of all matches with /ALL"
+//          [<opt> event! block!]
+//      port [port!]
+//      pattern "Event type, eventee, or BLANK! for GUI events"
+//          [word! port! object! blank!]
+//      /all "Return every match, in queue order"
+//  ]
+//
+DECLARE_NATIVE(find_events)
+{
+    EVENT_INCLUDE_PARAMS_OF_FIND_EVENTS;
+
+    Event_Queue *queue = Event_Queue_Of_Port(ARG(port));
+    return Find_Queued_Events(OUT, queue, ARG(pattern), did REF(all));
+}
+
+
+//
+//  export instantiate-event: native [
+//
+//  {Copy a template event, replacing the fields that vary}
+//
+//      return: [event!]
+//      template "e.g. `make event! [type: 'move flags: [shift]]`, made once"
+//          [event!]
+//      type "NULL to keep the template's"
+//          [<opt> word!]
+//      port "Eventee (BLANK! for GUI events), NULL to keep the template's"
+//          [<opt> port! object! blank!]
+//      offset "NULL to keep the template's"
+//          [<opt> pair!]
+//      key "NULL to keep the template's"
+//          [<opt> char! word!]
+//  ]
+//
+DECLARE_NATIVE(instantiate_event)
+//
+// MAKE EVENT! has to walk its spec block and look up every SET-WORD! field
+// by name, for each event made.  When a producer makes many events of the
+// same shape, it can MAKE one template and instantiate it: the template's
+// cell is copied and the positional arguments are written straight into
+// its bits, with no block walk.
+{
+    EVENT_INCLUDE_PARAMS_OF_INSTANTIATE_EVENT;
+
+    Copy_Cell(OUT, ARG(template));
+
+    if (not Is_Nulled(ARG(type)) and not Set_Event_Type(OUT, ARG(type)))
+        fail (Error_Bad_Value(ARG(type)));
+
+    if (not Is_Nulled(ARG(port)) and not Set_Event_Eventee(OUT, ARG(port)))
+        fail (Error_Bad_Value(ARG(port)));
+
+    if (not Is_Nulled(ARG(offset)) and not Set_Event_Offset(OUT, ARG(offset)))
+        fail (Error_Bad_Value(ARG(offset)));
+
+    if (not Is_Nulled(ARG(key)) and not Set_Event_Key(OUT, ARG(key)))
+        fail (Error_Bad_Value(ARG(key)));
+
+    return OUT;
+}
+
+
+//
+//  export event-flag?: native [
+//
+//  {Test one of an event's modifier flags, without making a FLAGS block}
+//
+//      return: [logic!]
+//      event [event!]
+//      flag "DOUBLE, CONTROL, or SHIFT"
+//          [word!]
+//  ]
+//
+DECLARE_NATIVE(event_flag_q)
+{
+    EVENT_INCLUDE_PARAMS_OF_EVENT_FLAG_Q;
+
+    Byte flags = VAL_EVENT_FLAGS(ARG(event));
+
+    switch (VAL_WORD_ID(ARG(flag))) {
+      case SYM_DOUBLE:
+        return Init_Logic(OUT, did (flags & EVF_DOUBLE));
+
+      case SYM_CONTROL:
+        return Init_Logic(OUT, did (flags & EVF_CONTROL));
+
+      case SYM_SHIFT:
+        return Init_Logic(OUT, did (flags & EVF_SHIFT));
+
+      default:
+        break;
+    }
+
+    fail (PARAM(flag));
+}
+
+
+//
+//  export event-fields: native [
+//
+//  {Read several fields from one event, or from each of a block of events}
+//
+//      return: "Values in field order, event by event (BLANK! if absent)"
+//          [block!]
+//      events [event! block!]
+//      fields "Any of TYPE PORT OFFSET KEY FLAGS CODE DATA"
+//          [block!]
+//      /into "Clear and fill this block (not EVENTS or FIELDS) instead"
+//          [block!]
+//  ]
+//
+DECLARE_NATIVE(event_fields)
+//
+// A handler that PICKs five fields goes through five generic dispatches and
+// five field name lookups per event.  Here the names are checked once, and
+// everything for a whole batch of events comes back in one flat block:
+//
+//     for-each [type offset] event-fields events [type offset] [...]
+{
+    EVENT_INCLUDE_PARAMS_OF_EVENT_FIELDS;
+
+    Cell(const*) fields_tail;
+    Cell(const*) fields_head = VAL_ARRAY_AT(&fields_tail, ARG(fields));
+
+    Cell(const*) field;
+    for (field = fields_head; field != fields_tail; ++field) {
+        if (not IS_WORD(field))
+            fail (Error_Bad_Value(field));
+
+        switch (VAL_WORD_ID(field)) {
+          case SYM_TYPE:
+          case SYM_PORT:
+          case SYM_OFFSET:
+          case SYM_KEY:
+          case SYM_FLAGS:
+          case SYM_CODE:
+          case SYM_DATA:
+            break;
+
+          default:
+            fail (Error_Bad_Value(field));
+        }
+    }
+
+    Cell(const*) events_tail;
+    Cell(const*) events_head;
+    if (IS_EVENT(ARG(events))) {
+        events_head = ARG(events);
+        events_tail = events_head + 1;
+    }
+    else {
+        events_head = VAL_ARRAY_AT(&events_tail, ARG(events));
+
+        Cell(const*) item;
+        for (item = events_head; item != events_tail; ++item) {
+            if (not IS_EVENT(item))
+                fail (Error_Bad_Value(item));
+        }
+    }
+
+    REBLEN total = (events_tail - events_head) * (fields_tail - fields_head);
+
+    Array(*) a;
+    if (REF(into)) {
+        a = VAL_ARRAY_ENSURE_MUTABLE(ARG(into));
+
+        // Clearing INTO before reading would lose the very cells being read
+        //
+        if (
+            (IS_BLOCK(ARG(events)) and VAL_ARRAY(ARG(events)) == a)
+            or VAL_ARRAY(ARG(fields)) == a
+        ){
+            fail ("EVENT-FIELDS /INTO can't be the EVENTS or FIELDS block");
+        }
+
+        SET_SERIES_LEN(a, 0);
+    }
+    else
+        a = Make_Array(total);
+
+    DECLARE_LOCAL (value);
+
+    Cell(const*) event;
+    for (event = events_head; event != events_tail; ++event) {
+        for (field = fields_head; field != fields_tail; ++field) {
+            if (Get_Event_Var(value, event, VAL_WORD_SYMBOL(field)))
+                Copy_Cell(Alloc_Tail_Array(a), value);
+            else
+                Init_Blank(Alloc_Tail_Array(a));
+        }
+    }
+
+    if (REF(into))
+        return COPY(ARG(into));
+
+    return Init_Block(OUT, a);
+}
+
+
+// Columns exchanged by EVENTS-TO-COLUMNS and EVENTS-FROM-COLUMNS, with the
+// bytes per event of each (integers are little-endian).  X and Y are the two
+// 16-bit halves of the event's data, so for key events they hold the keysym
+// and the keycode.
+//
+#define EVENT_COLUMN_TYPE_SIZE 2  // SymId
+#define EVENT_COLUMN_FLAGS_SIZE 1  // EVF_XXX
+#define EVENT_COLUMN_MODEL_SIZE 1  // EVM_XXX
+#define EVENT_COLUMN_XY_SIZE 2
+
+
+//
+//  Alloc_Event_Column: C
+//
+// Make a BINARY! of `size` bytes as an API handle, and return its data.
+//
+static Byte *Alloc_Event_Column(REBVAL **out, REBLEN size)
+{
+    *out = rebValue("make binary!", rebI(size));
+    Binary(*) bin = VAL_BINARY_ENSURE_MUTABLE(*out);
+    TERM_BIN_LEN(bin, size);
+    return BIN_HEAD(bin);
+}
+
+
+//
+//  export events-to-columns: native [
+//
+//  {Unpack events into parallel packed columns, one entry per event}
+//
+//      return: "COUNT, and BINARY! columns TYPES FLAGS MODELS X Y, EVENTEES"
+//          [object!]
+//      source "Events, or an event port (its queue is not consumed)"
+//          [block! port!]
+//  ]
+//
+DECLARE_NATIVE(events_to_columns)
+//
+// TYPES are 16-bit symbol ids, FLAGS and MODELS are bytes, and X and Y are
+// unsigned 16-bit (keysym and keycode for key events).  EVENTEES is a BLOCK!
+// of the PORT! or OBJECT! each event is for, BLANK! for GUI events.  The
+// file of a DROP-FILE event is not carried over.
+{
+    EVENT_INCLUDE_PARAMS_OF_EVENTS_TO_COLUMNS;
+
+    Event_Queue *queue = nullptr;
+    Cell(const*) head = nullptr;
+    REBLEN n;
+    if (IS_PORT(ARG(source))) {
+        queue = Event_Queue_Of_Port(ARG(source));
+        n = Event_Queue_Length(queue);
+    }
+    else {
+        Cell(const*) tail;
+        head = VAL_ARRAY_AT(&tail, ARG(source));
+        n = tail - head;
+
+        Cell(const*) item;
+        for (item = head; item != tail; ++item) {
+            if (not IS_EVENT(item))
+                fail (Error_Bad_Value(item));
+        }
+    }
+
+    REBVAL *types;
+    REBVAL *flags;
+    REBVAL *models;
+    REBVAL *xs;
+    REBVAL *ys;
+    Byte *tp = Alloc_Event_Column(&types, n * EVENT_COLUMN_TYPE_SIZE);
+    Byte *fp = Alloc_Event_Column(&flags, n * EVENT_COLUMN_FLAGS_SIZE);
+    Byte *mp = Alloc_Event_Column(&models, n * EVENT_COLUMN_MODEL_SIZE);
+    Byte *xp = Alloc_Event_Column(&xs, n * EVENT_COLUMN_XY_SIZE);
+    Byte *yp = Alloc_Event_Column(&ys, n * EVENT_COLUMN_XY_SIZE);
+
+    REBVAL *eventees = rebValue("make block!", rebI(n));
+    Array(*) a = VAL_ARRAY_ENSURE_MUTABLE(eventees);
+
+    REBLEN i;
+    for (i = 0; i < n; ++i) {
+        Cell(const*) event = queue ? Event_Queue_At(queue, i) : head + i;
+
+        uint16_t type = VAL_EVENT_TYPE(event);
+        *tp++ = cast(Byte, type);
+        *tp++ = cast(Byte, type >> 8);
+
+        *fp++ = VAL_EVENT_FLAGS(event);
+        *mp++ = VAL_EVENT_MODEL(event);
+
+        uint16_t x = VAL_EVENT_X(event);
+        *xp++ = cast(Byte, x);
+        *xp++ = cast(Byte, x >> 8);
+
+        uint16_t y = VAL_EVENT_Y(event);
+        *yp++ = cast(Byte, y);
+        *yp++ = cast(Byte, y >> 8);
+
+        if (VAL_EVENT_MODEL(event) == EVM_PORT)
+            Init_Port(Alloc_Tail_Array(a), CTX(VAL_EVENT_NODE(event)));
+        else if (VAL_EVENT_MODEL(event) == EVM_OBJECT)
+            Init_Object(Alloc_Tail_Array(a), CTX(VAL_EVENT_NODE(event)));
+        else
+            Init_Blank(Alloc_Tail_Array(a));
+    }
+
+    return rebValue("make object! [",
+        "count:", rebI(n),
+        "types:", rebR(types),
+        "flags:", rebR(flags),
+        "models:", rebR(models),
+        "x:", rebR(xs),
+        "y:", rebR(ys),
+        "eventees:", rebR(eventees),
+    "]");
+}
+
+
+//
+//  Event_Column_At: C
+//
+// Get a column from an EVENTS-TO-COLUMNS object, checking it is big enough.
+//
+static const Byte *Event_Column_At(
+    const REBVAL *columns,
+    const char *name,
+    REBLEN size
+){
+    REBVAL *column = rebValue("pick", columns, "to word!", rebT(name));
+    if (not column or not IS_BINARY(column)) {
+        rebRelease(column);
+        fail ("Event columns need BINARY! TYPES, FLAGS, MODELS, X and Y");
+    }
+
+    Size have;
+    const Byte *data = VAL_BINARY_SIZE_AT(&have, column);
+    rebRelease(column);  // object still holds the binary
+
+    if (have < size)
+        fail ("Event column is shorter than COUNT events");
+    return data;
+}
+
+
+//
+//  export events-from-columns: native [
+//
+//  {Pack columns like those from EVENTS-TO-COLUMNS back into events}
+//
+//      return: [block!]
+//      columns "COUNT, and BINARY! TYPES FLAGS MODELS X Y, BLOCK! EVENTEES"
+//          [object!]
+//  ]
+//
+DECLARE_NATIVE(events_from_columns)
+{
+    EVENT_INCLUDE_PARAMS_OF_EVENTS_FROM_COLUMNS;
+
+    REBVAL *columns = ARG(columns);
+    REBLEN n = rebUnboxInteger("pick", columns, "'count");
+
+    const Byte *tp = Event_Column_At(
+        columns, "types", n * EVENT_COLUMN_TYPE_SIZE
+    );
+    const Byte *fp = Event_Column_At(
+        columns, "flags", n * EVENT_COLUMN_FLAGS_SIZE
+    );
+    const Byte *mp = Event_Column_At(
+        columns, "models", n * EVENT_COLUMN_MODEL_SIZE
+    );
+    const Byte *xp = Event_Column_At(columns, "x", n * EVENT_COLUMN_XY_SIZE);
+    const Byte *yp = Event_Column_At(columns, "y", n * EVENT_COLUMN_XY_SIZE);
+
+    REBVAL *eventees = rebValue("ensure block! pick", columns, "'eventees");
+    Cell(const*) eventees_tail;
+    Cell(const*) eventee = VAL_ARRAY_AT(&eventees_tail, eventees);
+    if (cast(REBLEN, eventees_tail - eventee) < n) {
+        rebRelease(eventees);
+        fail ("Event column is shorter than COUNT events");
+    }
+
+    Array(*) a = Make_Array(n);
+
+    REBLEN i;
+    for (i = 0; i < n; ++i, ++eventee) {
+        Byte model = *mp++;
+
+        Node* node = nullptr;
+        if (IS_PORT(eventee) or IS_OBJECT(eventee))
+            node = CTX_VARLIST(VAL_CONTEXT(eventee));
+
+        if (
+            (model == EVM_PORT and not IS_PORT(eventee))
+            or (model == EVM_OBJECT and not IS_OBJECT(eventee))
+            or (model != EVM_PORT and model != EVM_OBJECT and node)
+            or model >= EVM_MAX
+        ){
+            rebRelease(eventees);
+            fail ("Event column MODELS does not match EVENTEES");
+        }
+
+        uint16_t type = tp[0] | (tp[1] << 8);
+        tp += 2;
+        if (type == SYM_0 or type >= ALL_SYMS_MAX) {
+            rebRelease(eventees);
+            fail ("Event column TYPES has an id that is not a symbol");
+        }
+
+        REBVAL *event = SPECIFIC(Alloc_Tail_Array(a));
+        Init_Event(event, cast(SymId, type), *fp++, model, node, 0);
+        SET_VAL_EVENT_X(event, xp[0] | (xp[1] << 8));
+        SET_VAL_EVENT_Y(event, yp[0] | (yp[1] << 8));
+        xp += 2;
+        yp += 2;
+    }
+
+    rebRelease(eventees);
+    return Init_Block(OUT, a);
+}
+
+
+//
+//  export mold-events: native [
+//
+//  {Mold a block of events, one per line, in a single buffer}
+//
+//      return: [text!]
+//      events [block!]
+//  ]
+//
+DECLARE_NATIVE(mold_events)
+//
+// Same text for each event as MOLD, but the mold buffer is reserved once for
+// the whole capture (at a typical size per event) rather than grown as it
+// goes, and there's no generic dispatch per item.
+{
+    EVENT_INCLUDE_PARAMS_OF_MOLD_EVENTS;
+
+    Cell(const*) tail;
+    Cell(const*) head = VAL_ARRAY_AT(&tail, ARG(events));
+
+    Cell(const*) item;
+    for (item = head; item != tail; ++item) {
+        if (not IS_EVENT(item))
+            fail (Error_Bad_Value(item));
+    }
+
+    DECLARE_MOLD (mo);
+    mo->reserve = (tail - head) * 64;  // e.g. type, offset and flags
+    Push_Mold(mo);
+
+    for (item = head; item != tail; ++item) {
+        MF_Event(mo, item, false);
+        Append_Codepoint(mo->series, LF);
+    }
+
+    return Init_Text(OUT, Pop_Molded_String(mo));
+}
+
+
+//
+//  export unique-events: native [
+//
+//  {Copy of a block of events with duplicates removed, keeping first ones}
+//
+//      return: [block!]
+//      events [block!]
+//      /strict "Also distinguish bits that don't affect the event's meaning"
+//  ]
+//
+DECLARE_NATIVE(unique_events)
+//
+// Generic UNIQUE compares each item with those already kept, which is
+// quadratic.  Here a hash table over Hash_Event() makes it O(n).  (MAP!
+// hashing is done by the core, which doesn't call out to extension types,
+// so this is the set operation the extension can speed up on its own.)
+{
+    EVENT_INCLUDE_PARAMS_OF_UNIQUE_EVENTS;
+
+    bool strict = did REF(strict);
+
+    Cell(const*) tail;
+    Cell(const*) head = VAL_ARRAY_AT(&tail, ARG(events));
+    REBSPC *specifier = VAL_SPECIFIER(ARG(events));
+    REBLEN n = tail - head;
+
+    Cell(const*) item;
+    for (item = head; item != tail; ++item) {
+        if (not IS_EVENT(item))
+            fail (Error_Bad_Value(item));
+    }
+
+    REBLEN size = 16;
+    while (size < n * 2)  // keep the load factor at most 1/2
+        size *= 2;
+
+    // Scratch space is an unmanaged series, so a fail() freeing it means a
+    // failed Make_Array() or Alloc_Tail_Array() below doesn't leak it.
+    //
+    Binary(*) bin = Make_Binary(sizeof(uint32_t) * size);
+    uint32_t *table = cast(uint32_t*, BIN_HEAD(bin));
+    memset(table, 0xFF, sizeof(uint32_t) * size);  // 0xFFFFFFFF is empty
+
+    Array(*) a = Make_Array(n);
+
+    for (item = head; item != tail; ++item) {
+        REBLEN i = Hash_Event(item, strict) & (size - 1);
+        for (; table[i] != 0xFFFFFFFF; i = (i + 1) & (size - 1)) {
+            if (Cmp_Event(head + table[i], item, strict) == 0)
+                goto duplicate;
+        }
+        table[i] = item - head;
+        Derelativize(Alloc_Tail_Array(a), item, specifier);
+
+      duplicate:
+        continue;
+    }
+
+    Free_Unmanaged_Series(bin);
+    return Init_Block(OUT, a);
+}
+
+
+// Model names for FILTER-EVENTS/MODEL, indexed by EVM_XXX.
+//
+static const char *Event_Model_Names[EVM_MAX] = {
+    "port",
+    "object",
+    "gui",
+    "callback"
+};
+
+
+//
+//  export filter-events: native [
+//
+//  {Select events from a block by type, model and flags}
+//
+//      return: "Matching events, or see /COUNT /INDICES /PARTITION"
+//          [block! integer!]
+//      events [block!]
+//      /type [word!]
+//      /model "PORT, OBJECT, GUI or CALLBACK"
+//          [word!]
+//      /flags "Flags that must all be set, e.g. [control shift]"
+//          [block!]
+//      /count "Return the number of matches"
+//      /indices "Return the 1-based positions of the matches"
+//      /partition "Return a BLOCK! of two blocks, matches and the rest"
+//  ]
+//
+DECLARE_NATIVE(filter_events)
+//
+// Type, flags and model all live in the cell's EXTRA word, so one masked
+// compare against a pattern built with the same byte macros tests all the
+// criteria at once.  Matching positions are then compacted without branches
+// (always write the index, advance the count by the match result), which
+// keeps the loop free of mispredictions on unsorted captures.
+{
+    EVENT_INCLUDE_PARAMS_OF_FILTER_EVENTS;
+
+    if ((did REF(count)) + (did REF(indices)) + (did REF(partition)) > 1)
+        fail (Error_Bad_Refines_Raw());
+
+    uintptr_t mask = 0;
+    uintptr_t pattern = 0;
+
+    if (REF(type)) {
+        option(SymId) type = VAL_WORD_ID(ARG(type));
+        if (not type)
+            fail (PARAM(type));  // events only have symbol types
+        SET_FIRST_UINT16(mask, 0xFFFF);
+        SET_FIRST_UINT16(pattern, unwrap(type));
+    }
+
+    if (REF(flags)) {
+        DECLARE_LOCAL (scratch);
+        Init_Event(scratch, SYM_NONE, EVF_MASK_NONE, EVM_GUI, nullptr, 0);
+        if (not Set_Event_Flags(scratch, ARG(flags)))
+            fail (PARAM(flags));
+        mutable_THIRD_BYTE(mask) = VAL_EVENT_FLAGS(scratch);
+        mutable_THIRD_BYTE(pattern) = VAL_EVENT_FLAGS(scratch);
+    }
+
+    if (REF(model)) {
+        const char *name = STR_UTF8(VAL_WORD_SYMBOL(ARG(model)));
+        Byte model;
+        for (model = 0; model < EVM_MAX; ++model) {
+            if (0 == strcmp(name, Event_Model_Names[model]))
+                break;
+        }
+        if (model == EVM_MAX)
+            fail (PARAM(model));
+        mutable_FOURTH_BYTE(mask) = 0xFF;
+        mutable_FOURTH_BYTE(pattern) = model;
+    }
+
+    Cell(const*) tail;
+    Cell(const*) head = VAL_ARRAY_AT(&tail, ARG(events));
+    REBSPC *specifier = VAL_SPECIFIER(ARG(events));
+    REBLEN n = tail - head;
+
+    // Scratch space is an unmanaged series (freed if anything below fails)
+    // holding both the match and the miss positions.
+    //
+    Binary(*) bin = nullptr;
+    uint32_t *matches = nullptr;
+    uint32_t *misses = nullptr;
+    if (not REF(count)) {
+        bin = Make_Binary(sizeof(uint32_t) * (n + 1) * 2);
+        matches = cast(uint32_t*, BIN_HEAD(bin));
+        misses = matches + (n + 1);
+    }
+
+    bool all_events = true;
+    REBLEN num_matches = 0;
+    REBLEN i;
+    for (i = 0; i < n; ++i) {
+        Cell(const*) item = head + i;
+        all_events &= IS_EVENT(item);
+
+        bool match = ((EXTRA(Any, item).u ^ pattern) & mask) == 0;
+        if (matches) {
+            matches[num_matches] = i;
+            misses[i - num_matches] = i;
+        }
+        num_matches += match;
+    }
+
+    if (not all_events) {
+        for (i = 0; IS_EVENT(head + i); ++i)
+            continue;
+        fail (Error_Bad_Value(head + i));
+    }
+
+    if (REF(count))
+        return Init_Integer(OUT, num_matches);
+
+    Array(*) a = Make_Array(num_matches);
+    for (i = 0; i < num_matches; ++i) {
+        if (REF(indices))
+            Init_Integer(Alloc_Tail_Array(a), matches[i] + 1);
+        else
+            Derelativize(Alloc_Tail_Array(a), head + matches[i], specifier);
+    }
+
+    if (REF(partition)) {
+        Array(*) rest = Make_Array(n - num_matches);
+        for (i = 0; i < n - num_matches; ++i)
+            Derelativize(Alloc_Tail_Array(rest), head + misses[i], specifier);
+
+        Array(*) pair = Make_Array(2);
+        Init_Block(Alloc_Tail_Array(pair), a);
+        Init_Block(Alloc_Tail_Array(pair), rest);
+        a = pair;
+    }
+
+    Free_Unmanaged_Series(bin);
+    return Init_Block(OUT, a);
+}
+
+
+//
+//  export encode-events: native [
+//
+//  {Binary capture of a block of events (see %reb-event.h for the format)}
+//
+//      return: [binary!]
+//      events [block!]
+//      /eventees "Block to append the eventee table to (else discarded)"
+//          [block!]
+//  ]
+//
+DECLARE_NATIVE(encode_events)
+{
+    EVENT_INCLUDE_PARAMS_OF_ENCODE_EVENTS;
 
+    REBVAL *eventees = REF(eventees) ? ARG(eventees) : rebValue("copy []");
+    REBVAL *binary = Encode_Events(ARG(events), eventees);
+    if (not REF(eventees))
+        rebRelease(eventees);
 
-Symbol(const*) S_Event(void) {
-    return Canon(EVENT_X);
+    return binary;
 }
 
 
 //
-//  startup*: native [  ; Note: DO NOT EXPORT!
+//  export decode-events: native [
 //
-//  {Make the EVENT! datatype work with GENERIC actions, comparison ops, etc}
+//  {Events from a binary capture, as made by ENCODE-EVENTS or RECORD-EVENTS}
 //
-//      return: <none>
+//      return: [block!]
+//      capture [binary!]
+//      /eventees "Table the records' eventee indices refer to"
+//          [block!]
+//      /port "Eventee for events whose eventee isn't in the table"
+//          [port!]
 //  ]
 //
-DECLARE_NATIVE(startup_p)
+DECLARE_NATIVE(decode_events)
 {
-    EVENT_INCLUDE_PARAMS_OF_STARTUP_P;
+    EVENT_INCLUDE_PARAMS_OF_DECODE_EVENTS;
 
-    // !!! See notes on Hook_Datatype for this poor-man's substitute for a
-    // coherent design of an extensible object system (as per Lisp's CLOS)
+    Size size;
+    const Byte *bp = VAL_BINARY_SIZE_AT(&size, ARG(capture));
+    uint32_t count = Check_Event_Capture_Header(bp, size);
+    bp += EVENT_CAPTURE_HEADER_SIZE;
+
+    const REBVAL *eventees = REF(eventees) ? ARG(eventees) : nullptr;
+    const REBVAL *port = REF(port) ? ARG(port) : nullptr;
+
+    Array(*) a = Make_Array(count);
+    for (; count != 0; --count, bp += EVENT_RECORD_SIZE)
+        Decode_Event_Record(SPECIFIC(Alloc_Tail_Array(a)), bp, eventees, port);
+
+    return Init_Block(OUT, a);
+}
+
+
+//
+//  export record-events: native [
+//
+//  {Record events queued into a port to a memory-mapped capture file}
+//
+//      return: [port!]
+//      port [port!]
+//      file [file!]
+//      /limit "Most events to record (default 1048576), later ones are missed"
+//          [integer!]
+//  ]
+//
+DECLARE_NATIVE(record_events)
+//
+// Recording continues until FINISH-RECORDING.  The file is created at the
+// size of /LIMIT records up front, so recording is only a store into memory
+// per event, and is truncated to the events recorded when it is finished.
+//
+// !!! Only implemented for POSIX.
+{
+    EVENT_INCLUDE_PARAMS_OF_RECORD_EVENTS;
+
+    Event_Queue *queue = Event_Queue_Of_Port(ARG(port));
+    if (queue->capture)
+        fail ("Event port is already recording");
+
+    uint32_t limit = 1024 * 1024;
+    if (REF(limit)) {
+        if (VAL_INT64(ARG(limit)) < 0 or VAL_INT64(ARG(limit)) > UINT32_MAX)
+            fail (Error_Out_Of_Range(ARG(limit)));
+        limit = cast(uint32_t, VAL_INT64(ARG(limit)));
+    }
+
+    Array(*) eventees = Make_Array(8);
+    Init_Block(Event_Queue_Eventees(queue), eventees);  // GC marks with port
+
+    char *path = rebSpell("file-to-local", ARG(file));
+    Event_Capture *capture = Start_Event_Capture(path, limit, eventees);
+    rebFree(path);
+    if (capture == nullptr) {
+        Init_Blank(Event_Queue_Eventees(queue));
+        fail ("Could not create and map event capture file");
+    }
+
+    queue->capture = capture;
+    return COPY(ARG(port));
+}
+
+
+//
+//  export finish-recording: native [
+//
+//  {Stop RECORD-EVENTS, completing the capture file}
+//
+//      return: "Eventee table, for REPLAY-EVENTS/EVENTEES"
+//          [block!]
+//      port [port!]
+//  ]
+//
+DECLARE_NATIVE(finish_recording)
+{
+    EVENT_INCLUDE_PARAMS_OF_FINISH_RECORDING;
+
+    Event_Queue *queue = Event_Queue_Of_Port(ARG(port));
+    if (not queue->capture)
+        fail ("Event port is not recording");
+
+    int error = Finish_Event_Capture(queue->capture);
+    queue->capture = nullptr;
+
+    Cell(*) eventees = Event_Queue_Eventees(queue);
+    Copy_Cell(OUT, SPECIFIC(eventees));
+    Init_Blank(eventees);
+
+    if (error != 0)  // file still has the unused records' space at the end
+        rebFail_OS (error);
+
+    return OUT;
+}
+
+
+//
+//  Cleanup_Event_File_Mapping: C
+//
+static void Cleanup_Event_File_Mapping(const REBVAL *v)
+{
+    Event_File_Mapping *m = VAL_HANDLE_POINTER(Event_File_Mapping, v);
+    if (m->handle != -1)
+        Unmap_Event_File(m, m->size);
+    free(m);
+}
+
+
+//
+//  export replay-events: native [
+//
+//  {Queue events from a capture file into a port, with their recorded timing}
+//
+//      return: "Number of events replayed"
+//          [integer!]
+//      port [port!]
+//      file [file!]
+//      /speed "2.0 is twice as fast as recorded, 0 is without any delays"
+//          [integer! decimal!]
+//      /eventees "Table from FINISH-RECORDING, else all events are for PORT"
+//          [block!]
+//  ]
+//
+DECLARE_NATIVE(replay_events)
+//
+// Events are subject to the port's limit and overflow policy as usual, so
+// if the policy is BLOCK a full queue is an error (as with APPEND).  The
+// replay stops early if there is a halt request (e.g. Ctrl-C), which is then
+// left pending for the evaluator.
+//
+// !!! Only implemented for POSIX.
+{
+    EVENT_INCLUDE_PARAMS_OF_REPLAY_EVENTS;
+
+    Event_Queue *queue = Event_Queue_Of_Port(ARG(port));
+
+    double speed = 1.0;
+    if (REF(speed)) {
+        speed = IS_INTEGER(ARG(speed))
+            ? cast(double, VAL_INT64(ARG(speed)))
+            : VAL_DECIMAL(ARG(speed));
+        if (speed < 0)
+            fail (Error_Out_Of_Range(ARG(speed)));
+    }
+    const REBVAL *eventees = REF(eventees) ? ARG(eventees) : nullptr;
+
+    Event_File_Mapping *file = cast(Event_File_Mapping*,
+        malloc(sizeof(Event_File_Mapping))
+    );
+    if (file == nullptr)
+        fail (Error_No_Memory(sizeof(Event_File_Mapping)));
+
+    char *path = rebSpell("file-to-local", ARG(file));
+    bool mapped = Map_Event_File(file, path, 0, false);
+    rebFree(path);
+    if (not mapped) {
+        free(file);
+        fail ("Could not open and map event capture file");
+    }
+
+    // If a corrupt record makes this fail, the GC unmaps the file.
     //
-    // !!! EVENT has a specific desire to use *all* of the bits in the cell.
-    // However, extension types generally do not have this option.  So we
-    // make a special exemption and allow REB_EVENT to take one of the
-    // builtin type bytes, so it can use the EXTRA() for more data.  This
-    // may or may not be worth it for this case...but it's a demonstration of
-    // a degree of freedom that we have.
+    Init_Handle_Cdata_Managed(
+        SPARE, file, sizeof(Event_File_Mapping), &Cleanup_Event_File_Mapping
+    );
 
-    const enum Reb_Kind k = REB_EVENT;
-    Builtin_Type_Hooks[k][IDX_SYMBOL_HOOK] = cast(CFUNC*, &S_Event);
-    Builtin_Type_Hooks[k][IDX_GENERIC_HOOK] = cast(CFUNC*, &T_Event);
-    Builtin_Type_Hooks[k][IDX_COMPARE_HOOK] = cast(CFUNC*, &CT_Event);
-    Builtin_Type_Hooks[k][IDX_MAKE_HOOK] = cast(CFUNC*, &MAKE_Event);
-    Builtin_Type_Hooks[k][IDX_TO_HOOK] = cast(CFUNC*, &TO_Event);
-    Builtin_Type_Hooks[k][IDX_MOLD_HOOK] = cast(CFUNC*, &MF_Event);
+    uint32_t count = Check_Event_Capture_Header(file->base, file->size);
+    const Byte *bp = file->base + EVENT_CAPTURE_HEADER_SIZE;
+    int64_t start = Monotonic_Nanoseconds();
 
-    Startup_Events();  // initialize other event stuff
+    DECLARE_LOCAL (event);
 
-    return NONE;
+    uint32_t i;
+    for (i = 0; i < count; ++i, bp += EVENT_RECORD_SIZE) {
+        if (speed != 0 and Clock_Is_Virtual) {
+            int64_t due = start
+                + cast(int64_t, Event_Record_Time(bp) / speed);
+            if (due > Virtual_Clock_Nanoseconds)
+                Virtual_Clock_Nanoseconds = due;
+        }
+        else if (speed != 0) {  // sleep in WAIT's way, to the millisecond
+            int64_t due = start
+                + cast(int64_t, Event_Record_Time(bp) / speed);
+            int64_t remaining;
+            while (
+                not GET_SIGNAL(SIG_HALT)
+                and (remaining = due - Monotonic_Nanoseconds()) >= 1000000
+            ){
+                Wait_Milliseconds_Interrupted(
+                    cast(unsigned int, remaining / 1000000)
+                );
+            }
+        }
+
+        if (GET_SIGNAL(SIG_HALT))
+            break;
+
+        Decode_Event_Record(event, bp, eventees, ARG(port));
+        if (not Enqueue_Event(queue, event))  // only refused if BLOCK
+            fail ("Event port queue is full (overflow policy is BLOCK)");
+    }
+
+    Unmap_Event_File(file, 0);  // handle's cleanup will then only free it
+    return Init_Integer(OUT, i);
 }
 
 
 //
-//  shutdown*: native [  ; Note: DO NOT EXPORT!
+//  export event-clock: native [
 //
-//  {Remove behaviors for EVENT! added by REGISTER-EVENT-HOOKS}
+//  {Nanoseconds on the clock WAIT uses, for measuring how long waits take}
+//
+//      return: [integer!]
+//      /cpu "CPU time used by the process instead of elapsed time"
+//  ]
+//
+DECLARE_NATIVE(event_clock)
+//
+// The elapsed clock is monotonic, so only differences are meaningful.
+{
+    EVENT_INCLUDE_PARAMS_OF_EVENT_CLOCK;
+
+    if (REF(cpu))
+        return Init_Integer(OUT, Process_Cpu_Nanoseconds());
+
+    return Init_Integer(OUT, Monotonic_Nanoseconds());
+}
+
+
+//
+//  export wait-backend: native [
+//
+//  {Name of the mechanism WAIT sleeps in, optionally switching it first}
+//
+//      return: [word!]
+//      /use "Switch to EPOLL or SELECT (Linux), SELECT (other POSIX)"
+//          [word!]
+//  ]
+//
+DECLARE_NATIVE(wait_backend)
+{
+    EVENT_INCLUDE_PARAMS_OF_WAIT_BACKEND;
+
+    if (REF(use)) {
+        const char *name = STR_UTF8(VAL_WORD_SYMBOL(ARG(use)));
+        if (not Use_Wait_Backend(name))
+            fail (PARAM(use));
+    }
+
+    return rebValue("to word!", rebT(Wait_Backend_Name()));
+}
+
+
+//
+//  export post-event-later: native [
+//
+//  {Post an event to a port from another thread after a delay}
 //
 //      return: <none>
+//      port [port!]
+//      delay [integer! decimal! time!]
+//      event [event!]
 //  ]
 //
-DECLARE_NATIVE(shutdown_p)
+DECLARE_NATIVE(post_event_later)
+//
+// This is a harness for measuring how quickly WAIT wakes up for a port that
+// is fed from outside the interpreter thread.  If the port is closed before
+// the delay is up, the event is dropped.
 {
-    EVENT_INCLUDE_PARAMS_OF_SHUTDOWN_P;
+    EVENT_INCLUDE_PARAMS_OF_POST_EVENT_LATER;
 
-    // !!! See notes in register-event-hooks for why we reach below the
-    // normal custom type machinery to pack an event into a single cell
-    //
-    const enum Reb_Kind k = REB_EVENT;
-    Builtin_Type_Hooks[k][IDX_GENERIC_HOOK] = cast(CFUNC*, &T_Unhooked);
-    Builtin_Type_Hooks[k][IDX_COMPARE_HOOK] = cast(CFUNC*, &CT_Unhooked);
-    Builtin_Type_Hooks[k][IDX_MAKE_HOOK] = cast(CFUNC*, &MAKE_Unhooked);
-    Builtin_Type_Hooks[k][IDX_TO_HOOK] = cast(CFUNC*, &TO_Unhooked);
-    Builtin_Type_Hooks[k][IDX_MOLD_HOOK] = cast(CFUNC*, &MF_Unhooked);
+    Event_Post_Queue *pq = Event_Post_Queue_Of_Port(ARG(port), EVENTS_CHUNK);
 
-    // !!! currently no shutdown code, but there once was for destroying an
-    // invisible handle in windows...
+    Posted_Event posted;
+    posted.type = VAL_EVENT_TYPE(ARG(event));
+    posted.flags = VAL_EVENT_FLAGS(ARG(event));
+    posted.data = VAL_EVENT_DATA(ARG(event));
+
+    if (not Post_Event_Later(pq, &posted, Milliseconds_From_Value(ARG(delay))))
+        fail ("Could not start a thread to post the event");
 
     return NONE;
 }
 
 
+//
+//  export dump-event-trace: native [
+//
+//  {Recorded event subsystem trace as Chrome `about://tracing` JSON}
+//
+//      return: [text!]
+//      /clear "Discard the records after dumping them"
+//  ]
+//
+DECLARE_NATIVE(dump_event_trace)
+//
+// Only available in builds with DEBUG_EVENT_TRACE (see %reb-event.h).  Save
+// the result to a .json file and load it in the trace viewer.
+{
+    EVENT_INCLUDE_PARAMS_OF_DUMP_EVENT_TRACE;
+
+  #if DEBUG_EVENT_TRACE
+    DECLARE_MOLD (mo);
+    Push_Mold(mo);
+    Mold_Event_Trace(mo);
+
+    if (REF(clear))
+        Clear_Event_Trace();
+
+    return Init_Text(OUT, Pop_Molded_String(mo));
+  #else
+    UNUSED(REF(clear));
+    fail ("Event tracing requires a build with DEBUG_EVENT_TRACE=1");
+  #endif
+}
+
+
+bool Clock_Is_Virtual = false;
+int64_t Virtual_Clock_Nanoseconds = 0;
+
+
+//
+//  export virtual-clock: native [
+//
+//  {Make WAIT and EVENT-CLOCK use a clock that only moves when told to}
+//
+//      return: "Whether the clock was virtual before"
+//          [logic!]
+//      virtual [logic!]
+//  ]
+//
+DECLARE_NATIVE(virtual_clock)
+//
+// For tests of timer-driven code: a WAIT with a timeout returns as soon as
+// nothing is ready, with the clock advanced to the deadline, so it takes no
+// real time and always sees the same times.
+//
+// The virtual clock starts from the real one, but it isn't brought back
+// when switching to real time again.  So times taken under one clock should
+// not be compared against the other.
+{
+    EVENT_INCLUDE_PARAMS_OF_VIRTUAL_CLOCK;
+
+    bool was_virtual = Clock_Is_Virtual;
+    bool virtual = did VAL_LOGIC(ARG(virtual));
+
+    if (virtual and not was_virtual)
+        Virtual_Clock_Nanoseconds = Real_Monotonic_Nanoseconds();
+    Clock_Is_Virtual = virtual;
+
+    return Init_Logic(OUT, was_virtual);
+}
+
+
+//
+//  export advance-clock: native [
+//
+//  {Move the virtual clock forward}
+//
+//      return: "The clock's new time, as from EVENT-CLOCK"
+//          [integer!]
+//      amount [integer! decimal! time!]
+//  ]
+//
+DECLARE_NATIVE(advance_clock)
+{
+    EVENT_INCLUDE_PARAMS_OF_ADVANCE_CLOCK;
+
+    if (not Clock_Is_Virtual)
+        fail ("ADVANCE-CLOCK requires VIRTUAL-CLOCK to be on");
+
+    int64_t nanoseconds = Nanoseconds_From_Value(ARG(amount));
+    if (nanoseconds < 0)
+        fail (Error_Out_Of_Range(ARG(amount)));
+
+    Virtual_Clock_Nanoseconds += nanoseconds;
+    return Init_Integer(OUT, Virtual_Clock_Nanoseconds);
+}
+
+
+//
+//  export set-timeout: native [
+//
+//  {Queue a TIME event into a port after a delay, and optionally repeat it}
+//
+//      return: "Id for CANCEL-TIMEOUT, also the CODE of the TIME event"
+//          [integer!]
+//      port [port!]
+//      delay [integer! decimal! time!]
+//      /period "Queue it again at this interval, until cancelled"
+//          [integer! decimal! time!]
+//  ]
+//
+DECLARE_NATIVE(set_timeout)
+//
+// Timeouts fire while WAIT is running, from a timing wheel (see TIMEOUTS in
+// %reb-event.h), so a port can have as many as it has connections to time
+// out.  Closing the port cancels them, as does the port being garbage
+// collected--so the port must stay referenced for its timeouts to fire.
+{
+    EVENT_INCLUDE_PARAMS_OF_SET_TIMEOUT;
+
+    int64_t delay = Nanoseconds_From_Value(ARG(delay));
+    if (delay < 0)
+        fail (Error_Out_Of_Range(ARG(delay)));
+
+    int64_t period = 0;
+    if (REF(period)) {
+        period = Nanoseconds_From_Value(ARG(period));
+        if (period <= 0)
+            fail (Error_Out_Of_Range(ARG(period)));
+    }
+
+    Event_Queue *queue = Event_Queue_Of_Port(ARG(port));
+    uint64_t id = Set_Event_Timeout(queue, delay, period);
+    if (id == 0)
+        fail ("Could not set timeout (out of memory, or too many pending)");
+
+    return Init_Integer(OUT, cast(REBI64, id));
+}
+
+
+//
+//  export cancel-timeout: native [
+//
+//  {Stop a timeout from SET-TIMEOUT from firing (again)}
+//
+//      return: "False if it wasn't pending (e.g. a one-shot that fired)"
+//          [logic!]
+//      id [integer!]
+//  ]
+//
+DECLARE_NATIVE(cancel_timeout)
+{
+    EVENT_INCLUDE_PARAMS_OF_CANCEL_TIMEOUT;
+
+    REBI64 id = VAL_INT64(ARG(id));
+    if (id <= 0)
+        return Init_Logic(OUT, false);
+
+    return Init_Logic(OUT, Cancel_Event_Timeout(cast(uint64_t, id)));
+}
+
+
 #define MAX_WAIT_MS 64 // Maximum millsec to sleep
 
+// Longest single sleep when WAIT doesn't have to poll devices (fits the int
+// that epoll_wait() takes, where -1 would mean forever).
+//
+#define MAX_BLOCK_MS INT_MAX
+
+// Sleeps are bucketed by powers of 2 (1, 2-3, 4-7, ... 64+ milliseconds).
+//
+#define WAIT_HISTOGRAM_BUCKETS 8
+
+// Counters for the WAIT* loop, reported by EVENT-STATS.  They are plain
+// increments and two extra clock reads per round, which is cheap enough to
+// leave on in release builds.
+//
+static struct {
+    uint64_t iterations;  // rounds of the loop
+    uint64_t busy_polls;  // OS_Poll_Devices() found activity
+    uint64_t idle_polls;
+    int64_t poll_nanoseconds;  // total time in OS_Poll_Devices()
+    int64_t max_poll_nanoseconds;
+    uint64_t sleeps;  // calls to Wait_Milliseconds_Interrupted()
+    uint64_t interrupted;  // ...ended by EINTR (or a message on Windows)
+    uint64_t source_ready;  // ...ended by a registered readiness source
+    uint64_t timeouts_fired;  // TIME events queued by SET-TIMEOUT timeouts
+    uint64_t histogram[WAIT_HISTOGRAM_BUCKETS];  // effective wait_millisec
+} Wait_Stats;
+
+inline static REBLEN Wait_Histogram_Bucket(REBLEN millisec) {
+    REBLEN bucket = 0;
+    while (millisec > 1 and bucket < WAIT_HISTOGRAM_BUCKETS - 1) {
+        millisec >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
 
 //
 //  export wait*: native [
@@ -117,6 +1371,7 @@ DECLARE_NATIVE(shutdown_p)
 //      return: "NULL if timeout, PORT! that awoke or BLOCK! of ports if /ALL"
 //          [<opt> port! block!]
 //      value [<opt> any-number! time! port! block!]
+//      /all "Return all ready ports in a BLOCK!, instead of just the first"
 //  ]
 //
 DECLARE_NATIVE(wait_p)  // See wrapping function WAIT in usermode code
@@ -180,7 +1435,23 @@ DECLARE_NATIVE(wait_p)  // See wrapping function WAIT in usermode code
         }
     }
 
-    REBI64 base = Delta_Time(0);
+    // Deadline is kept in monotonic nanoseconds, so stepping the wall clock
+    // (e.g. NTP) can't end the wait early or stretch it out.
+    //
+    int64_t deadline = 0;
+    if (timeout != ALL_BITS)
+        deadline = Monotonic_Nanoseconds() + cast(int64_t, timeout) * 1000000;
+
+    // Event ports being waited on are stamped with this WAIT's id, so each
+    // round only has to look at ports that actually have events queued.
+    //
+    // If that's also all the WAIT is on, they can't need device polling to
+    // get events, so sleeps block until the deadline or next timeout (or a
+    // readiness source) instead of being sliced.
+    //
+    bool block = false;
+    uint32_t wait_id = ports ? Begin_Event_Wait(ports, &block) : 0;
+
     REBLEN wait_millisec = 1;
     REBLEN res = (timeout >= 1000) ? 0 : 16;  // OS dependent?
 
@@ -190,6 +1461,9 @@ DECLARE_NATIVE(wait_p)  // See wrapping function WAIT in usermode code
     assert(TG_Jump_List != nullptr);
 
     while (wait_millisec != 0) {
+        ++Wait_Stats.iterations;
+        TRACE_EVENT(EVENT_TRACE_WAIT_ITERATION, 0, wait_millisec);
+
         if (GET_SIGNAL(SIG_HALT)) {
             CLR_SIGNAL(SIG_HALT);
 
@@ -206,45 +1480,193 @@ DECLARE_NATIVE(wait_p)  // See wrapping function WAIT in usermode code
             fail ("BREAKPOINT from SIG_INTERRUPT not currently implemented");
         }
 
+        int64_t base_wait = Monotonic_Nanoseconds();  // start timing
+
+        Wait_Stats.timeouts_fired += Run_Event_Timeouts(base_wait);
+
+        if (ports and Ready_Event_Ports(OUT, wait_id, did REF(all)))
+            return OUT;
+
         if (timeout != ALL_BITS) {
-            //
-            // Figure out how long that (and OS_WAIT) took:
-            //
-            REBLEN time = cast(REBLEN, Delta_Time(base) / 1000);
-            if (time >= timeout)
+            int64_t remaining = deadline - base_wait;
+            if (remaining <= 0)
                 break;  // done (was dt = 0 before)
-            else if (wait_millisec > timeout - time)  // use smaller residual time
-                wait_millisec = timeout - time;
-        }
 
-        int64_t base_wait = Delta_Time(0);  // start timing
+            // Only convert to milliseconds when the residual time is smaller
+            // than the slice, rounding up so we don't wake just short of it.
+            //
+            if (cast(int64_t, wait_millisec) * 1000000 > remaining)
+                wait_millisec = cast(REBLEN, (remaining + 999999) / 1000000);
+        }
 
         // Let any pending device I/O have a chance to run:
         //
-        if (OS_Poll_Devices()) {
+        // Only the poll itself is timed, and on the real clock, since a
+        // virtual one doesn't move while it runs.
+        //
+        int64_t poll_start = Real_Monotonic_Nanoseconds();
+        bool activity = OS_Poll_Devices();
+        TRACE_EVENT(EVENT_TRACE_POLL, poll_start, activity);
+
+        int64_t elapsed = Real_Monotonic_Nanoseconds() - poll_start;
+        Wait_Stats.poll_nanoseconds += elapsed;
+        if (elapsed > Wait_Stats.max_poll_nanoseconds)
+            Wait_Stats.max_poll_nanoseconds = elapsed;
+
+        if (activity) {
+            ++Wait_Stats.busy_polls;
             //
             // Some activity, so use low wait time.
             //
             wait_millisec = 1;
             continue;
         }
+        ++Wait_Stats.idle_polls;
+
+        // Whichever comes first of the WAIT's own deadline and the next
+        // timeout is as long as this round can sleep.
+        //
+        int64_t wake = Next_Event_Timeout();  // INT64_MAX if none
+        if (timeout != ALL_BITS and deadline < wake)
+            wake = deadline;
+
+        // A virtual clock jumps to that time rather than sleeping.  (With
+        // nothing to jump to, the wait really sleeps until a port gets an
+        // event.)
+        //
+        // Readiness sources (e.g. of a 'timer port) are on the real clock,
+        // though.  While any are registered, jumping to other ports'
+        // timeouts would spin until a source fired, with how many of those
+        // timeouts ran depending on real time.  So then the clock only
+        // jumps to this WAIT's deadline or its own ports' timeouts, and
+        // otherwise the wait really sleeps on the sources.
+        //
+        if (Clock_Is_Virtual and wake != INT64_MAX) {
+            if (Poll_Event_Sources()) {
+                ++Wait_Stats.source_ready;
+                continue;
+            }
+            if (Have_Event_Sources()) {
+                wake = ports ? Next_Event_Wait_Timeout(ports) : INT64_MAX;
+                if (timeout != ALL_BITS and deadline < wake)
+                    wake = deadline;
+            }
+            if (wake != INT64_MAX) {
+                if (wake > Virtual_Clock_Nanoseconds)
+                    Virtual_Clock_Nanoseconds = wake;
+                continue;
+            }
+        }
+
+        if (block) {
+            if (wake == INT64_MAX)
+                wait_millisec = MAX_BLOCK_MS;  // a source or signal ends it
+            else {
+                int64_t until = wake - Monotonic_Nanoseconds();
+                if (until <= 0)
+                    continue;
+                if (until >= cast(int64_t, MAX_BLOCK_MS) * 1000000)
+                    wait_millisec = MAX_BLOCK_MS;
+                else
+                    wait_millisec = cast(REBLEN, (until + 999999) / 1000000);
+            }
+        }
+        else {
+            // No activity (nothing to do) so increase the wait time
+            //
+            wait_millisec *= 2;
+            if (wait_millisec > MAX_WAIT_MS)
+                wait_millisec = MAX_WAIT_MS;
+
+            // Nothing, so wait for period of time
+
+            unsigned int delta = cast(unsigned int, elapsed / 1000000) + res;
+            if (delta >= wait_millisec)
+                continue;
+
+            wait_millisec -= delta; // account for time lost above
+
+            if (wake != INT64_MAX) {
+                int64_t until = wake - Monotonic_Nanoseconds();
+                if (until <= 0)
+                    continue;
+                if (cast(int64_t, wait_millisec) * 1000000 > until)
+                    wait_millisec = cast(REBLEN, (until + 999999) / 1000000);
+            }
+        }
 
-        // No activity (nothing to do) so increase the wait time
+        // The yield ends early if a registered readiness source fires (its
+        // callback has already run by the time this returns).  Treat that
+        // like device activity, so the next round polls again promptly.
         //
-        wait_millisec *= 2;
-        if (wait_millisec > MAX_WAIT_MS)
-            wait_millisec = MAX_WAIT_MS;
+        ++Wait_Stats.sleeps;
+        ++Wait_Stats.histogram[Wait_Histogram_Bucket(wait_millisec)];
 
-        // Nothing, so wait for period of time
+        int64_t trace_start = TRACE_CLOCK();
+        enum Reb_Wait_Result result = Wait_Milliseconds_Interrupted(
+            wait_millisec
+        );
+        TRACE_EVENT(EVENT_TRACE_SLEEP, trace_start, wait_millisec);
+        TRACE_EVENT(EVENT_TRACE_WAKE, 0, result);
 
-        unsigned int delta = Delta_Time(base_wait) / 1000 + res;
-        if (delta >= wait_millisec)
-            continue;
+        switch (result) {
+          case WAIT_TIMED_OUT:
+            break;
 
-        wait_millisec -= delta; // account for time lost above
+          case WAIT_INTERRUPTED:
+            ++Wait_Stats.interrupted;
+            break;
 
-        Wait_Milliseconds_Interrupted(wait_millisec);
+          case WAIT_SOURCE_READY:
+            ++Wait_Stats.source_ready;
+            wait_millisec = 1;
+            break;
+        }
     }
 
     return nullptr;
 }
+
+
+//
+//  export event-stats: native [
+//
+//  {Counters describing what the WAIT loop has been doing}
+//
+//      return: [object!]
+//      /reset "Zero the counters (after reporting them)"
+//  ]
+//
+DECLARE_NATIVE(event_stats)
+//
+// HISTOGRAM has one count per power of 2 of milliseconds slept, starting at
+// 1ms, with the last bucket counting everything from 64ms up.  Times are in
+// nanoseconds on the real monotonic clock, even if the virtual one is on.
+{
+    EVENT_INCLUDE_PARAMS_OF_EVENT_STATS;
+
+    REBVAL *histogram = rebValue("make block!", rebI(WAIT_HISTOGRAM_BUCKETS));
+    REBLEN i;
+    for (i = 0; i < WAIT_HISTOGRAM_BUCKETS; ++i)
+        rebElide("append", histogram, rebI(Wait_Stats.histogram[i]));
+
+    REBVAL *stats = rebValue("make object! [",
+        "iterations:", rebI(Wait_Stats.iterations),
+        "busy-polls:", rebI(Wait_Stats.busy_polls),
+        "idle-polls:", rebI(Wait_Stats.idle_polls),
+        "poll-time:", rebI(Wait_Stats.poll_nanoseconds),
+        "max-poll-time:", rebI(Wait_Stats.max_poll_nanoseconds),
+        "sleeps:", rebI(Wait_Stats.sleeps),
+        "interrupted:", rebI(Wait_Stats.interrupted),
+        "source-ready:", rebI(Wait_Stats.source_ready),
+        "timeouts:", rebI(Pending_Event_Timeouts()),
+        "timeouts-fired:", rebI(Wait_Stats.timeouts_fired),
+        "histogram:", histogram,
+    "]");
+    rebRelease(histogram);
+
+    if (REF(reset))
+        memset(&Wait_Stats, 0, sizeof(Wait_Stats));
+
+    return stats;
+}
@@ -53,8 +53,1153 @@
 
 #include "reb-event.h"
 
-#define EVENTS_LIMIT 0xFFFF //64k
-#define EVENTS_CHUNK 128
+
+// Overflow policy names, indexed by enum Reb_Event_Overflow.
+//
+static const char *Event_Overflow_Names[EVQ_OVERFLOW_MAX] = {
+    "block",
+    "drop-oldest",
+    "drop-newest",
+    "coalesce"
+};
+
+
+// Queues that are not empty, most recently readied first (see WAIT*)
+//
+static Event_Queue *Ready_Queues = nullptr;
+
+static uint32_t Last_Wait_Id = 0;
+
+
+// Event port properties and policies aren't core symbols, so they are
+// matched by their spelling.
+//
+static bool Is_Word_Named(Cell(const*) word, const char *name)
+  { return 0 == strcmp(STR_UTF8(VAL_WORD_SYMBOL(word)), name); }
+
+
+//
+//  Nanoseconds_From_Value: C
+//
+// Durations are TIME!, or seconds as INTEGER! or DECIMAL! (as for WAIT).
+//
+int64_t Nanoseconds_From_Value(Cell(const*) v)
+{
+    if (IS_TIME(v))
+        return VAL_NANO(v);
+    if (IS_INTEGER(v))
+        return VAL_INT64(v) * 1000000000;
+    if (IS_DECIMAL(v))
+        return cast(int64_t, VAL_DECIMAL(v) * 1000000000);
+
+    fail (Error_Bad_Value(v));
+}
+
+
+//
+//  Event_Overflow_From_Word: C
+//
+enum Reb_Event_Overflow Event_Overflow_From_Word(Cell(const*) word)
+{
+    int i;
+    for (i = 0; i < EVQ_OVERFLOW_MAX; ++i) {
+        if (Is_Word_Named(word, Event_Overflow_Names[i]))
+            return cast(enum Reb_Event_Overflow, i);
+    }
+    fail (Error_Bad_Value(word));
+}
+
+
+// Slot in a post queue.  This is Dmitry Vyukov's bounded queue: a slot is
+// free for the producer claiming position `pos` when its sequence is `pos`,
+// and holds a finished event for the consumer when it is `pos + 1`.
+//
+typedef struct {
+    uintptr_t sequence;  // atomic
+    Posted_Event event;
+} Posted_Event_Slot;
+
+struct Reb_Event_Post_Queue {
+    Event_Queue *queue;  // where the interpreter thread moves events to
+    Posted_Event_Slot *slots;
+    uintptr_t mask;  // number of slots - 1
+
+    uintptr_t enqueue_pos;  // atomic, contended by producers
+    uintptr_t dequeue_pos;  // only used by the interpreter thread
+
+    uintptr_t wakeup_pending;  // atomic, nonzero if wakeup was signaled
+    Event_Wakeup wakeup;
+    Event_Source source;
+    bool registered;  // false if the wakeup couldn't be a readiness source
+
+    uintptr_t refs;  // atomic, the port's reference plus producers' ones
+    uintptr_t closed;  // atomic, nonzero once the port let go of the queue
+};
+
+
+//
+//  Retain_Event_Post_Queue: C
+//
+// A producer thread that might still be posting when the port is closed
+// (or collected) must hold a reference, so the post queue stays valid.
+//
+void Retain_Event_Post_Queue(Event_Post_Queue *pq)
+{
+    Atomic_Fetch_Add(&pq->refs, 1);
+}
+
+
+//
+//  Release_Event_Post_Queue: C
+//
+// Safe from any thread.  Whoever drops the last reference frees the queue,
+// which can only be a producer if the port has already let go of it.
+//
+void Release_Event_Post_Queue(Event_Post_Queue *pq)
+{
+    if (Atomic_Fetch_Add(&pq->refs, UINTPTR_MAX) != 1)  // i.e. subtract 1
+        return;
+
+    Close_Event_Wakeup(&pq->wakeup);
+    free(pq->slots);
+    free(pq);
+}
+
+
+//
+//  Close_Event_Post_Queue: C
+//
+// The port's side of letting go, on CLOSE or when the port is collected.
+// This stops the wakeup from being a readiness source and makes further
+// posts fail, but the memory and the wakeup descriptor are only freed when
+// producers holding references are done with them.
+//
+static void Close_Event_Post_Queue(Event_Post_Queue *pq)
+{
+    if (pq->registered)
+        Unregister_Event_Source(&pq->source);
+    pq->registered = false;
+    pq->queue = nullptr;
+    Atomic_Store(&pq->closed, 1);
+    Release_Event_Post_Queue(pq);
+}
+
+
+//
+//  Set_Event_Queue_Ready: C
+//
+// O(1) maintenance of the ready list, done when a queue goes from empty to
+// not empty and back.
+//
+static void Set_Event_Queue_Ready(Event_Queue *q, bool ready)
+{
+    if (q->ready == ready)
+        return;
+
+    if (ready) {
+        q->prev_ready = nullptr;
+        q->next_ready = Ready_Queues;
+        if (Ready_Queues)
+            Ready_Queues->prev_ready = q;
+        Ready_Queues = q;
+    }
+    else {
+        if (q->prev_ready)
+            q->prev_ready->next_ready = q->next_ready;
+        else
+            Ready_Queues = q->next_ready;
+        if (q->next_ready)
+            q->next_ready->prev_ready = q->prev_ready;
+    }
+    q->ready = ready;
+}
+
+
+//
+//  Cleanup_Event_Queue: C
+//
+// GC hook for the HANDLE! in an event port's STATE.  This runs during the
+// GC's sweep, so it must not allocate or use the API.
+//
+static void Cleanup_Event_Queue(const REBVAL *v)
+{
+    Event_Queue *q = VAL_HANDLE_POINTER(Event_Queue, v);
+    Set_Event_Queue_Ready(q, false);  // port is gone, can't be waited on
+    if (q->posts)
+        Close_Event_Post_Queue(q->posts);
+    if (q->capture)
+        Free_Event_Capture(q->capture);
+    if (q->timer)
+        Disarm_Event_Timer(q->timer);
+    Cancel_Event_Timeouts(q);
+    free(q->enqueued_at);
+    free(q->next_of_type);
+    free(q);
+}
+
+
+//
+//  Reset_Event_Type_Chains: C
+//
+static void Reset_Event_Type_Chains(Event_Queue *q)
+{
+    memset(q->chains, 0, sizeof(q->chains));  // SYM_0 types, zero counts
+    q->unindexed = false;
+}
+
+
+//
+//  Event_Type_Chain_For: C
+//
+// Open-addressed lookup of a type's chain.  With `add`, an unused chain is
+// claimed for the type if there is one.  Chains stay claimed when their
+// count drops to zero, and are only released when the queue is emptied.
+//
+static Event_Type_Chain *Event_Type_Chain_For(
+    Event_Queue *q,
+    SymId type,
+    bool add
+){
+    REBLEN mask = EVENT_TYPE_CHAINS - 1;
+    REBLEN i = type & mask;
+    REBLEN n;
+    for (n = 0; n < EVENT_TYPE_CHAINS; ++n, i = (i + 1) & mask) {
+        Event_Type_Chain *c = &q->chains[i];
+        if (c->type == type)
+            return c;
+        if (c->type == SYM_0) {
+            if (not add)
+                return nullptr;
+            c->type = type;
+            c->count = 0;
+            return c;
+        }
+    }
+
+    if (add)
+        q->unindexed = true;
+    return nullptr;
+}
+
+
+//
+//  Index_Tail_Event: C
+//
+// Link the event with sequence `seq` (the newest) onto its type's chain.
+//
+static void Index_Tail_Event(Event_Queue *q, uint32_t seq, SymId type)
+{
+    REBLEN mask = q->capacity - 1;
+    q->next_of_type[seq & mask] = 0;
+
+    Event_Type_Chain *c = Event_Type_Chain_For(q, type, true);
+    if (c == nullptr)
+        return;
+
+    if (c->count == 0)
+        c->first = seq;
+    else
+        q->next_of_type[c->last & mask] = seq - c->last;
+    c->last = seq;
+    ++c->count;
+}
+
+
+//
+//  Unindex_Head_Event: C
+//
+// The head event is always the oldest of its type, so it is the first link
+// in its chain.
+//
+static void Unindex_Head_Event(Event_Queue *q, SymId type)
+{
+    Event_Type_Chain *c = Event_Type_Chain_For(q, type, false);
+    if (c == nullptr)
+        return;  // type wasn't indexed
+
+    assert(c->count != 0 and c->first == q->head);
+    if (--c->count != 0)
+        c->first = q->head + q->next_of_type[q->head & (q->capacity - 1)];
+}
+
+
+//
+//  Note_Event_Latency: C
+//
+// Count the time the event with sequence `seq` spent queued, as it leaves.
+//
+static void Note_Event_Latency(Event_Queue *q, uint32_t seq, int64_t now)
+{
+    int64_t latency = now - q->enqueued_at[seq & (q->capacity - 1)];
+    if (latency > q->max_latency)
+        q->max_latency = latency;
+
+    uint64_t micro = cast(uint64_t, latency) / 1000;
+    REBLEN bucket = 0;
+    while (micro > 1 and bucket < EVENT_LATENCY_BUCKETS - 1) {
+        micro >>= 1;
+        ++bucket;
+    }
+    ++q->latency_histogram[bucket];
+}
+
+
+//
+//  Track_Event_Latency: C
+//
+// Turn latency tracking on or off.  Events already queued when it is turned
+// on are counted from now.
+//
+void Track_Event_Latency(Event_Queue *q, bool on)
+{
+    if (not on) {
+        free(q->enqueued_at);
+        q->enqueued_at = nullptr;
+        return;
+    }
+
+    if (q->enqueued_at)
+        return;
+
+    q->enqueued_at = cast(int64_t*, malloc(sizeof(int64_t) * q->capacity));
+    if (q->enqueued_at == nullptr)
+        fail (Error_No_Memory(sizeof(int64_t) * q->capacity));
+
+    memset(q->latency_histogram, 0, sizeof(q->latency_histogram));
+    q->max_latency = 0;
+
+    int64_t now = Monotonic_Nanoseconds();
+    uint32_t seq;
+    for (seq = q->head; seq != q->tail; ++seq)
+        q->enqueued_at[seq & (q->capacity - 1)] = now;
+}
+
+
+//
+//  Make_Event_Ring: C
+//
+static Array(*) Make_Event_Ring(REBLEN capacity)
+{
+    assert((capacity & (capacity - 1)) == 0);  // power of 2
+
+    Array(*) ring = Make_Array(capacity);
+    REBLEN i;
+    for (i = 0; i < capacity; ++i)
+        Init_Blank(Alloc_Tail_Array(ring));
+    return ring;
+}
+
+
+//
+//  Event_Ring: C
+//
+// The ring is an ordinary BLOCK! in the port's DATA, so usermode could have
+// overwritten it.  Check it's still the shape the queue expects.
+//
+static Array(*) Event_Ring(Event_Queue *q)
+{
+    REBVAL *data = CTX_VAR(q->port, STD_PORT_DATA);
+    if (not IS_BLOCK(data) or VAL_LEN_HEAD(data) != q->capacity)
+        fail ("Event port DATA is not the queue's ring (was it modified?)");
+
+    return VAL_ARRAY_KNOWN_MUTABLE(data);
+}
+
+
+//
+//  Event_Queue_Of_Port: C
+//
+// Get the queue for an event port, creating it on first use.
+//
+Event_Queue *Event_Queue_Of_Port(const REBVAL *port)
+{
+    Context(*) ctx = VAL_CONTEXT(port);
+    REBVAL *state = CTX_VAR(ctx, STD_PORT_STATE);
+    if (IS_BLOCK(state)) {
+        if (
+            VAL_LEN_HEAD(state) != 2
+            or not IS_HANDLE(ARR_HEAD(VAL_ARRAY(state)))
+        ){
+            fail ("Event port STATE is not the queue's (was it modified?)");
+        }
+        return VAL_HANDLE_POINTER(Event_Queue, ARR_HEAD(VAL_ARRAY(state)));
+    }
+
+    Array(*) ring = Make_Event_Ring(EVENTS_CHUNK);  // may fail, so do first
+    Array(*) slots = Make_Array(2);
+
+    Event_Queue *q = cast(Event_Queue*, malloc(sizeof(Event_Queue)));
+    if (q == nullptr)
+        fail (Error_No_Memory(sizeof(Event_Queue)));
+
+    q->next_of_type = cast(uint32_t*,
+        malloc(sizeof(uint32_t) * EVENTS_CHUNK)
+    );
+    if (q->next_of_type == nullptr) {
+        free(q);
+        fail (Error_No_Memory(sizeof(uint32_t) * EVENTS_CHUNK));
+    }
+    Reset_Event_Type_Chains(q);
+
+    q->port = ctx;
+    q->head = 0;
+    q->tail = 0;
+    q->capacity = EVENTS_CHUNK;
+    q->limit = EVENTS_LIMIT;
+
+    q->overflow = EVQ_OVERFLOW_BLOCK;
+    q->coalesce_motion = false;
+    q->refused = 0;
+    q->dropped = 0;
+    q->coalesced = 0;
+
+    q->enqueued_at = nullptr;
+    memset(q->latency_histogram, 0, sizeof(q->latency_histogram));
+    q->max_latency = 0;
+
+    q->posts = nullptr;
+    q->capture = nullptr;
+    q->timer = nullptr;
+    q->timeouts = 0;
+
+    q->ready = false;
+    q->prev_ready = nullptr;
+    q->next_ready = nullptr;
+    q->wait_id = 0;
+
+    Init_Block(CTX_VAR(ctx, STD_PORT_DATA), ring);
+    Init_Handle_Cdata_Managed(
+        Alloc_Tail_Array(slots), q, sizeof(Event_Queue), &Cleanup_Event_Queue
+    );
+    Init_Blank(Alloc_Tail_Array(slots));  // eventees, see RECORD-EVENTS
+    Init_Block(state, slots);
+    return q;
+}
+
+
+//
+//  Event_Queue_Eventees: C
+//
+// Where RECORD-EVENTS keeps its eventee table, in the port's STATE.
+//
+Cell(*) Event_Queue_Eventees(Event_Queue *q)
+{
+    REBVAL *state = CTX_VAR(q->port, STD_PORT_STATE);
+    assert(IS_BLOCK(state) and VAL_LEN_HEAD(state) == 2);
+    return ARR_AT(VAL_ARRAY_KNOWN_MUTABLE(state), 1);
+}
+
+
+//
+//  Grow_Event_Ring: C
+//
+// Double the ring.  Each live event moves to the slot its sequence number
+// maps to under the new mask, so head and tail stay as they were.
+//
+static void Grow_Event_Ring(Event_Queue *q)
+{
+    Array(*) old_ring = Event_Ring(q);
+    REBLEN old_mask = q->capacity - 1;
+
+    REBLEN capacity = q->capacity * 2;
+    Array(*) ring = Make_Event_Ring(capacity);
+
+    uint32_t *next_of_type = cast(uint32_t*,
+        malloc(sizeof(uint32_t) * capacity)
+    );
+    if (next_of_type == nullptr)
+        fail (Error_No_Memory(sizeof(uint32_t) * capacity));
+
+    int64_t *enqueued_at = nullptr;
+    if (q->enqueued_at) {
+        enqueued_at = cast(int64_t*, malloc(sizeof(int64_t) * capacity));
+        if (enqueued_at == nullptr) {
+            free(next_of_type);
+            fail (Error_No_Memory(sizeof(int64_t) * capacity));
+        }
+    }
+
+    uint32_t seq;
+    for (seq = q->head; seq != q->tail; ++seq) {
+        Copy_Cell(
+            ARR_AT(ring, seq & (capacity - 1)),
+            SPECIFIC(ARR_AT(old_ring, seq & old_mask))
+        );
+        next_of_type[seq & (capacity - 1)] = q->next_of_type[seq & old_mask];
+        if (enqueued_at)
+            enqueued_at[seq & (capacity - 1)] = q->enqueued_at[seq & old_mask];
+    }
+
+    free(q->next_of_type);
+    q->next_of_type = next_of_type;
+    if (enqueued_at) {
+        free(q->enqueued_at);
+        q->enqueued_at = enqueued_at;
+    }
+    q->capacity = capacity;
+    Init_Block(CTX_VAR(q->port, STD_PORT_DATA), ring);
+}
+
+
+//
+//  Shift_Event: C
+//
+// O(1).  Returns false if there was nothing queued.  The vacated slot is set
+// to BLANK! so it doesn't keep the event's eventee alive.  Events that are
+// discarded rather than handed to a consumer don't count toward latency.
+//
+static bool Shift_Event(Value(*) out, Event_Queue *q, bool dispatched)
+{
+    if (q->head == q->tail)
+        return false;
+
+    if (dispatched and q->enqueued_at)
+        Note_Event_Latency(q, q->head, Monotonic_Nanoseconds());
+
+    Cell(*) slot = ARR_AT(Event_Ring(q), q->head & (q->capacity - 1));
+    Copy_Cell(out, SPECIFIC(slot));
+    Unindex_Head_Event(q, VAL_EVENT_TYPE(slot));
+    Init_Blank(slot);
+    ++q->head;
+
+    if (q->head == q->tail)
+        Set_Event_Queue_Ready(q, false);
+    return true;
+}
+
+
+//
+//  Coalesce_Into_Tail: C
+//
+// If the newest queued event came from the same source (type, model and
+// eventee), overwrite its data with the new event's and accumulate the
+// flags, so the queue holds the latest state without growing.
+//
+static bool Coalesce_Into_Tail(Event_Queue *q, const REBVAL *event)
+{
+    if (q->head == q->tail)
+        return false;
+
+    Cell(*) tail = ARR_AT(Event_Ring(q), (q->tail - 1) & (q->capacity - 1));
+    if (
+        VAL_EVENT_TYPE(tail) != VAL_EVENT_TYPE(event)
+        or VAL_EVENT_MODEL(tail) != VAL_EVENT_MODEL(event)
+        or VAL_EVENT_NODE(tail) != VAL_EVENT_NODE(event)
+        or ((VAL_EVENT_FLAGS(tail) | VAL_EVENT_FLAGS(event)) & EVF_COPIED)
+    ){
+        return false;
+    }
+
+    VAL_EVENT_DATA(tail) = VAL_EVENT_DATA(event);
+    mutable_VAL_EVENT_FLAGS(tail) |= VAL_EVENT_FLAGS(event);
+    ++q->coalesced;
+    return true;
+}
+
+
+//
+//  Enqueue_Event: C
+//
+// O(1) amortized.  If the queue is at its limit, what happens depends on the
+// port's overflow policy.  Returns false only if the event was refused (the
+// EVQ_OVERFLOW_BLOCK policy), in which case the producer has to try again
+// after the consumer has made room.
+//
+// With coalesce_motion on, an event carrying an offset (moves, drags...)
+// that matches the tail event's source just updates that event.  So a burst
+// of motion between two reads of the queue costs one slot, and the handler
+// still sees the final position and every modifier that was held.
+//
+bool Enqueue_Event(Event_Queue *q, const REBVAL *event)
+{
+    assert(IS_EVENT(event));
+
+    if (
+        q->coalesce_motion
+        and (VAL_EVENT_FLAGS(event) & EVF_HAS_XY)
+        and Coalesce_Into_Tail(q, event)
+    ){
+        return true;
+    }
+
+    if (Event_Queue_Length(q) >= q->limit) {
+        switch (q->overflow) {
+          case EVQ_OVERFLOW_BLOCK:
+            ++q->refused;
+            return false;
+
+          case EVQ_OVERFLOW_DROP_NEWEST:
+            ++q->dropped;
+            return true;
+
+          case EVQ_OVERFLOW_COALESCE:
+            if (Coalesce_Into_Tail(q, event))
+                return true;
+            goto drop_oldest;  // not mergeable, keep the newest state
+
+          case EVQ_OVERFLOW_DROP_OLDEST:
+          drop_oldest: {
+            DECLARE_LOCAL (discard);
+            while (Event_Queue_Length(q) >= q->limit) {  // limit may shrink
+                Shift_Event(discard, q, false);
+                ++q->dropped;
+            }
+            break; }
+
+          default:
+            assert(false);
+        }
+    }
+
+    if (Event_Queue_Length(q) == q->capacity)
+        Grow_Event_Ring(q);  // can't exceed 64k, since limit <= EVENTS_LIMIT
+
+    Array(*) ring = Event_Ring(q);
+    Copy_Cell(ARR_AT(ring, q->tail & (q->capacity - 1)), event);
+    Index_Tail_Event(q, q->tail, VAL_EVENT_TYPE(event));
+    if (q->enqueued_at)
+        q->enqueued_at[q->tail & (q->capacity - 1)] = Monotonic_Nanoseconds();
+    ++q->tail;
+
+    if (q->capture)
+        Capture_Event(q->capture, event);
+
+    Set_Event_Queue_Ready(q, true);
+
+    SET_SIGNAL(SIG_EVENT_PORT);
+    return true;
+}
+
+
+//
+//  Dequeue_Event: C
+//
+bool Dequeue_Event(Value(*) out, Event_Queue *q)
+{
+    return Shift_Event(out, q, true);
+}
+
+
+//
+//  Reserve_Event_Ring: C
+//
+// Grow ahead of a batch, instead of doubling partway through it.
+//
+static void Reserve_Event_Ring(Event_Queue *q, REBLEN extra)
+{
+    REBLEN wanted = MIN(Event_Queue_Length(q) + extra, q->limit);
+    while (q->capacity < wanted)
+        Grow_Event_Ring(q);
+}
+
+
+//
+//  Enqueue_Event_Block: C
+//
+// Every item is checked to be an EVENT! before any are queued, so a batch
+// is added entirely or not at all.  Under EVQ_OVERFLOW_BLOCK the whole
+// batch is refused if it doesn't fit.
+//
+static void Enqueue_Event_Block(Event_Queue *q, const REBVAL *block)
+{
+    Cell(const*) tail;
+    Cell(const*) head = VAL_ARRAY_AT(&tail, block);
+
+    Cell(const*) item;
+    for (item = head; item != tail; ++item) {
+        if (not IS_EVENT(item))
+            fail (Error_Bad_Value(item));
+    }
+
+    REBLEN n = tail - head;
+    if (
+        q->overflow == EVQ_OVERFLOW_BLOCK
+        and Event_Queue_Length(q) + n > q->limit
+    ){
+        q->refused += n;
+        fail ("Event port queue can't fit batch (overflow policy is BLOCK)");
+    }
+
+    Reserve_Event_Ring(q, n);
+
+    for (item = head; item != tail; ++item)
+        Enqueue_Event(q, SPECIFIC(item));
+}
+
+
+//
+//  Dequeue_Events: C
+//
+// Take up to `max` events from the head into a new array, in one pass.
+//
+static Array(*) Dequeue_Events(Event_Queue *q, REBLEN max)
+{
+    REBLEN n = MIN(max, Event_Queue_Length(q));
+    Array(*) a = Make_Array(n);
+
+    Array(*) ring = Event_Ring(q);
+    REBLEN mask = q->capacity - 1;
+    int64_t now = q->enqueued_at ? Monotonic_Nanoseconds() : 0;
+    for (; n != 0; --n, ++q->head) {
+        if (q->enqueued_at)
+            Note_Event_Latency(q, q->head, now);
+
+        Cell(*) slot = ARR_AT(ring, q->head & mask);
+        Copy_Cell(Alloc_Tail_Array(a), SPECIFIC(slot));
+        Unindex_Head_Event(q, VAL_EVENT_TYPE(slot));
+        Init_Blank(slot);
+    }
+
+    if (q->head == q->tail)
+        Set_Event_Queue_Ready(q, false);
+    return a;
+}
+
+
+//
+//  Clear_Event_Queue: C
+//
+void Clear_Event_Queue(Event_Queue *q)
+{
+    Array(*) ring = Event_Ring(q);
+    for (; q->head != q->tail; ++q->head)
+        Init_Blank(ARR_AT(ring, q->head & (q->capacity - 1)));
+
+    Reset_Event_Type_Chains(q);
+    Set_Event_Queue_Ready(q, false);
+}
+
+
+//
+//  Reindex_Event_Queue: C
+//
+// Rebuild all the type chains, e.g. after POKE changed an event in place.
+//
+static void Reindex_Event_Queue(Event_Queue *q)
+{
+    Reset_Event_Type_Chains(q);
+
+    Array(*) ring = Event_Ring(q);
+    uint32_t seq;
+    for (seq = q->head; seq != q->tail; ++seq) {
+        Cell(*) slot = ARR_AT(ring, seq & (q->capacity - 1));
+        Index_Tail_Event(q, seq, VAL_EVENT_TYPE(slot));
+    }
+}
+
+
+//
+//  Event_Matches: C
+//
+// See Find_Queued_Events() for what the pattern may be.
+//
+static bool Event_Matches(Cell(const*) event, const REBVAL *pattern)
+{
+    if (IS_WORD(pattern)) {
+        option(SymId) type = VAL_WORD_ID(pattern);  // events only use SymIds
+        return type and VAL_EVENT_TYPE(event) == unwrap(type);
+    }
+
+    if (IS_PORT(pattern))
+        return VAL_EVENT_MODEL(event) == EVM_PORT
+            and VAL_EVENT_NODE(event) == VAL_NODE1(pattern);
+
+    if (IS_OBJECT(pattern))
+        return VAL_EVENT_MODEL(event) == EVM_OBJECT
+            and VAL_EVENT_NODE(event) == VAL_NODE1(pattern);
+
+    assert(IS_BLANK(pattern));
+    return VAL_EVENT_MODEL(event) == EVM_GUI;
+}
+
+
+//
+//  Find_Queued_Events: C
+//
+// Look for queued events matching `pattern`: a WORD! for the event type, a
+// PORT! or OBJECT! for the eventee, or BLANK! for GUI events.  Lookups by
+// type follow that type's chain, the others scan the queue.
+//
+// Returns the first match (or nullptr if none), or with `all` a BLOCK! of
+// every match in queue order.  Nothing is dequeued.
+//
+REBVAL *Find_Queued_Events(
+    Value(*) out,
+    Event_Queue *q,
+    const REBVAL *pattern,
+    bool all
+){
+    if (not (
+        IS_WORD(pattern) or IS_PORT(pattern)
+        or IS_OBJECT(pattern) or IS_BLANK(pattern)
+    )){
+        fail (Error_Bad_Value(pattern));
+    }
+
+    Array(*) ring = Event_Ring(q);
+    REBLEN mask = q->capacity - 1;
+    Array(*) found = all ? Make_Array(0) : nullptr;
+
+    Event_Type_Chain *chain = nullptr;
+    if (IS_WORD(pattern)) {
+        option(SymId) type = VAL_WORD_ID(pattern);
+        if (type)
+            chain = Event_Type_Chain_For(q, unwrap(type), false);
+    }
+
+    if (chain or (IS_WORD(pattern) and not q->unindexed)) {
+        REBLEN n = chain ? chain->count : 0;  // no chain means no matches
+        uint32_t seq = chain ? chain->first : 0;
+        for (; n != 0; --n, seq += q->next_of_type[seq & mask]) {
+            Cell(*) slot = ARR_AT(ring, seq & mask);
+            if (not all)
+                return Copy_Cell(out, SPECIFIC(slot));
+            Copy_Cell(Alloc_Tail_Array(found), SPECIFIC(slot));
+        }
+    }
+    else {
+        uint32_t seq;
+        for (seq = q->head; seq != q->tail; ++seq) {
+            Cell(*) slot = ARR_AT(ring, seq & mask);
+            if (not Event_Matches(slot, pattern))
+                continue;
+            if (not all)
+                return Copy_Cell(out, SPECIFIC(slot));
+            Copy_Cell(Alloc_Tail_Array(found), SPECIFIC(slot));
+        }
+    }
+
+    if (not all)
+        return nullptr;
+
+    return Init_Block(out, found);
+}
+
+
+//
+//  Event_Queue_At: C
+//
+// Slot for the nth queued event (0 is the head), or nullptr if out of range.
+//
+Cell(*) Event_Queue_At(Event_Queue *q, REBINT n)
+{
+    if (n < 0 or cast(REBLEN, n) >= Event_Queue_Length(q))
+        return nullptr;
+
+    return ARR_AT(Event_Ring(q), (q->head + n) & (q->capacity - 1));
+}
+
+
+//
+//  Drain_Posted_Events: C
+//
+// Move events posted by other threads into the port's queue.  If the port's
+// overflow policy refuses one, it and everything after it stay posted (so
+// producers see the post queue fill up, and back off).
+//
+static void Drain_Posted_Events(Event_Post_Queue *pq)
+{
+    Event_Queue *q = pq->queue;
+    DECLARE_LOCAL (event);
+
+    for (;; ++pq->dequeue_pos) {
+        Posted_Event_Slot *slot = &pq->slots[pq->dequeue_pos & pq->mask];
+        if (Atomic_Load(&slot->sequence) != pq->dequeue_pos + 1)
+            break;  // empty, or the producer hasn't finished writing it
+
+        Init_Event(
+            event,
+            cast(SymId, slot->event.type),
+            slot->event.flags,
+            EVM_PORT,
+            CTX_VARLIST(q->port),
+            slot->event.data
+        );
+        if (not Enqueue_Event(q, event))
+            break;
+
+        Atomic_Store(&slot->sequence, pq->dequeue_pos + pq->mask + 1);
+    }
+}
+
+
+//
+//  Posted_Events_Ready: C
+//
+// Readiness source callback, run inside WAIT when the wakeup is signaled.
+// The pending flag is reset before draining, so a post racing with the
+// drain either gets drained now or signals the wakeup again.
+//
+static void Posted_Events_Ready(Event_Source *source)
+{
+    Event_Post_Queue *pq = cast(Event_Post_Queue*, source->context);
+    Clear_Event_Wakeup(&pq->wakeup);
+    Atomic_Store(&pq->wakeup_pending, 0);
+    Drain_Posted_Events(pq);
+}
+
+
+//
+//  Event_Post_Queue_Of_Port: C
+//
+// Get the port's post queue, creating it if needed.  Interpreter thread only;
+// the returned pointer can then be handed to producer threads.
+//
+Event_Post_Queue *Event_Post_Queue_Of_Port(
+    const REBVAL *port,
+    REBLEN capacity
+){
+    Event_Queue *q = Event_Queue_Of_Port(port);
+    if (q->posts)
+        return q->posts;
+
+    REBLEN size = EVENTS_CHUNK;
+    while (size < capacity and size <= EVENTS_LIMIT)
+        size *= 2;
+
+    Event_Post_Queue *pq = cast(Event_Post_Queue*,
+        malloc(sizeof(Event_Post_Queue))
+    );
+    if (pq == nullptr)
+        fail (Error_No_Memory(sizeof(Event_Post_Queue)));
+
+    pq->slots = cast(Posted_Event_Slot*,
+        malloc(sizeof(Posted_Event_Slot) * size)
+    );
+    if (pq->slots == nullptr) {
+        free(pq);
+        fail (Error_No_Memory(sizeof(Posted_Event_Slot) * size));
+    }
+
+    REBLEN i;
+    for (i = 0; i < size; ++i)
+        pq->slots[i].sequence = i;
+
+    pq->queue = q;
+    pq->mask = size - 1;
+    pq->enqueue_pos = 0;
+    pq->dequeue_pos = 0;
+    pq->wakeup_pending = 0;
+    pq->refs = 1;  // the port's
+    pq->closed = 0;
+
+    pq->registered = false;
+    if (Open_Event_Wakeup(&pq->wakeup)) {
+        pq->source.fd = pq->wakeup.read_fd;
+        pq->source.on_ready = &Posted_Events_Ready;
+        pq->source.context = pq;
+        pq->registered = Register_Event_Source(&pq->source);
+    }
+
+    q->posts = pq;
+    return pq;
+}
+
+
+//
+//  Post_Event: C
+//
+// Safe to call from any thread: it touches nothing but the post queue.  Does
+// not block, returning false if the post queue is full or its port closed.
+//
+bool Post_Event(Event_Post_Queue *pq, const Posted_Event *event)
+{
+    if (Atomic_Load(&pq->closed))
+        return false;
+
+    Posted_Event_Slot *slot;
+    uintptr_t pos = Atomic_Load(&pq->enqueue_pos);
+    for (;;) {
+        slot = &pq->slots[pos & pq->mask];
+        uintptr_t seq = Atomic_Load(&slot->sequence);
+        intptr_t diff = cast(intptr_t, seq) - cast(intptr_t, pos);
+        if (diff == 0) {
+            if (Atomic_Compare_Exchange(&pq->enqueue_pos, &pos, pos + 1))
+                break;  // slot claimed (on failure, pos was reloaded)
+        }
+        else if (diff < 0)
+            return false;  // full, consumer hasn't freed this slot yet
+        else
+            pos = Atomic_Load(&pq->enqueue_pos);  // another producer won
+    }
+
+    slot->event = *event;
+    Atomic_Store(&slot->sequence, pos + 1);  // publish to the consumer
+
+    if (Atomic_Exchange(&pq->wakeup_pending, 1) == 0)
+        Signal_Event_Wakeup(&pq->wakeup);
+    return true;
+}
+
+
+//
+//  Try_Event_Queue_Of_Port: C
+//
+// Like Event_Queue_Of_Port(), but returns nullptr if it isn't an event port.
+//
+Event_Queue *Try_Event_Queue_Of_Port(const REBVAL *port)
+{
+    REBVAL *actor = CTX_VAR(VAL_CONTEXT(port), STD_PORT_ACTOR);
+    if (
+        not IS_HANDLE(actor)
+        or VAL_HANDLE_CFUNC(actor) != cast(CFUNC*, &Event_Actor)
+    ){
+        return nullptr;
+    }
+    return Event_Queue_Of_Port(port);
+}
+
+
+//
+//  Begin_Event_Wait: C
+//
+// Stamp the queues of the event ports in a WAIT's block with a fresh id, so
+// Ready_Event_Ports() can tell which ready queues that WAIT cares about.
+// This walks the block once per WAIT instead of once per wakeup.
+//
+// `wakes` is set to whether every port in the block is an event port whose
+// events all arrive in a way that ends WAIT's sleep: timeouts, readiness
+// sources, and posts from other threads if the post queue's wakeup could be
+// registered.  If so, nothing waited on needs device polling to progress.
+//
+uint32_t Begin_Event_Wait(const REBVAL *ports, bool *wakes)
+{
+    if (++Last_Wait_Id == 0)  // 0 is never a valid id
+        ++Last_Wait_Id;
+
+    *wakes = true;
+
+    Cell(const*) tail;
+    Cell(const*) item = VAL_ARRAY_AT(&tail, ports);
+    for (; item != tail; ++item) {
+        if (not IS_PORT(item))
+            continue;
+
+        Event_Queue *q = Try_Event_Queue_Of_Port(SPECIFIC(item));
+        if (q == nullptr) {
+            *wakes = false;
+            continue;
+        }
+
+        if (q->posts) {  // events may have been posted since last action
+            Drain_Posted_Events(q->posts);
+            if (not q->posts->registered)
+                *wakes = false;
+        }
+        q->wait_id = Last_Wait_Id;
+    }
+    return Last_Wait_Id;
+}
+
+
+//
+//  Next_Event_Wait_Timeout: C
+//
+// When the soonest timeout of the event ports in a WAIT's block fires, or
+// INT64_MAX if they have none.  Timeouts of other ports don't count.
+//
+int64_t Next_Event_Wait_Timeout(const REBVAL *ports)
+{
+    int64_t next = INT64_MAX;
+
+    Cell(const*) tail;
+    Cell(const*) item = VAL_ARRAY_AT(&tail, ports);
+    for (; item != tail; ++item) {
+        if (not IS_PORT(item))
+            continue;
+
+        Event_Queue *q = Try_Event_Queue_Of_Port(SPECIFIC(item));
+        if (q == nullptr or q->timeouts == 0)
+            continue;
+
+        int64_t fires = Next_Event_Timeout_Of_Queue(q);
+        if (fires < next)
+            next = fires;
+    }
+    return next;
+}
+
+
+//
+//  Ready_Event_Ports: C
+//
+// Walk only the ready list, looking for queues stamped with `wait_id`.
+// Gives back the first such PORT!, or with `all` a BLOCK! of them.  Returns
+// nullptr if none of the waited-on ports have events.
+//
+REBVAL *Ready_Event_Ports(Value(*) out, uint32_t wait_id, bool all)
+{
+    Array(*) ready = nullptr;
+
+    Event_Queue *q;
+    for (q = Ready_Queues; q != nullptr; q = q->next_ready) {
+        if (q->wait_id != wait_id)
+            continue;
+
+        if (not all)
+            return Init_Port(out, q->port);
+
+        if (ready == nullptr)
+            ready = Make_Array(1);
+        Init_Port(Alloc_Tail_Array(ready), q->port);
+    }
+
+    if (ready == nullptr)
+        return nullptr;
+
+    return Init_Block(out, ready);
+}
+
+
+//
+//  Event_Queue_Stats: C
+//
+// Object with the queue's size, policy and overflow counters, given for
+// `reflect port 'stats`.
+//
+static REBVAL *Event_Queue_Stats(Event_Queue *q)
+{
+    REBVAL *stats = rebValue("make object! [",
+        "length:", rebI(Event_Queue_Length(q)),
+        "capacity:", rebI(q->capacity),
+        "limit:", rebI(q->limit),
+        "overflow: to word!", rebT(Event_Overflow_Names[q->overflow]),
+        "coalesce-motion:", rebL(q->coalesce_motion),
+        "refused:", rebI(q->refused),
+        "dropped:", rebI(q->dropped),
+        "coalesced:", rebI(q->coalesced),
+        "latency: _",  // filled in below if tracking
+        "max-latency: _",
+        "queue-age: _",
+    "]");
+
+    if (not q->enqueued_at)
+        return stats;
+
+    // LATENCY is the histogram (see EVENT_LATENCY_BUCKETS), MAX-LATENCY the
+    // longest any taken event waited, and QUEUE-AGE how long the event at
+    // the head has been waiting so far.  Times are in nanoseconds.
+    //
+    REBVAL *histogram = rebValue("make block!", rebI(EVENT_LATENCY_BUCKETS));
+    REBLEN i;
+    for (i = 0; i < EVENT_LATENCY_BUCKETS; ++i)
+        rebElide("append", histogram, rebI(q->latency_histogram[i]));
+
+    int64_t age = 0;
+    if (q->head != q->tail)
+        age = Delta_Nanoseconds(
+            q->enqueued_at[q->head & (q->capacity - 1)]
+        );
+
+    rebElide(
+        stats, ".latency:", histogram,
+        stats, ".max-latency:", rebI(q->max_latency),
+        stats, ".queue-age:", rebI(age)
+    );
+    rebRelease(histogram);
+    return stats;
+}
+
 
 //
 //  Event_Actor: C
@@ -66,15 +1211,16 @@ Bounce Event_Actor(Frame(*) frame_, REBVAL *port, Symbol(const*) verb)
     // Validate and fetch relevant PORT fields:
     //
     Context(*) ctx = VAL_CONTEXT(port);
-    REBVAL *state = CTX_VAR(ctx, STD_PORT_STATE);
     REBVAL *spec = CTX_VAR(ctx, STD_PORT_SPEC);
     if (!IS_OBJECT(spec))
         fail (Error_Invalid_Spec_Raw(spec));
 
     // Get or setup internal state data:
     //
-    if (!IS_BLOCK(state))
-        Init_Block(state, Make_Array(EVENTS_CHUNK - 1));
+    Event_Queue *queue = Event_Queue_Of_Port(port);
+
+    if (queue->posts)  // pick up anything other threads have posted
+        Drain_Posted_Events(queue->posts);
 
     switch (ID_OF_SYMBOL(verb)) {
 
@@ -82,59 +1228,123 @@ Bounce Event_Actor(Frame(*) frame_, REBVAL *port, Symbol(const*) verb)
         INCLUDE_PARAMS_OF_REFLECT;
 
         UNUSED(ARG(value)); // implicit in port
-        SymId property = VAL_WORD_ID(ARG(property));
-        assert(property != SYM_0);
+        option(SymId) property = VAL_WORD_ID(ARG(property));
 
         switch (property) {
         case SYM_LENGTH:
-            return Init_Integer(OUT, VAL_LEN_HEAD(state));
+            return Init_Integer(OUT, Event_Queue_Length(queue));
 
         default:
             break;
         }
 
+        if (Is_Word_Named(ARG(property), "stats")) {
+            REBVAL *stats = Event_Queue_Stats(queue);
+            Copy_Cell(OUT, stats);
+            rebRelease(stats);
+            return OUT;
+        }
+
         break; }
 
-    // Normal block actions done on events:
-    case SYM_POKE:
-        if (not IS_EVENT(D_ARG(3)))
-            fail (D_ARG(3));
-        goto act_blk;
+    case SYM_PICK_P: {
+        INCLUDE_PARAMS_OF_PICK_P;
+        UNUSED(ARG(location));
+
+        Cell(const*) picker = ARG(picker);
+        if (not IS_INTEGER(picker))
+            return BOUNCE_UNHANDLED;
+
+        Cell(*) slot = Event_Queue_At(queue, VAL_INT32(picker) - 1);
+        if (slot == nullptr)
+            return nullptr;
+
+        return Copy_Cell(OUT, SPECIFIC(slot)); }
+
+    case SYM_POKE_P: {
+        INCLUDE_PARAMS_OF_POKE_P;
+        UNUSED(ARG(location));
+
+        Cell(const*) picker = ARG(picker);
+        if (not IS_INTEGER(picker))
+            return BOUNCE_UNHANDLED;
+
+        REBVAL *setval = ARG(value);
+        if (Is_Isotope(setval) or not IS_EVENT(setval))
+            fail (setval);
+
+        Cell(*) slot = Event_Queue_At(queue, VAL_INT32(picker) - 1);
+        if (slot == nullptr)
+            fail (Error_Out_Of_Range(picker));
+
+        Copy_Cell(slot, setval);
+        Reindex_Event_Queue(queue);  // type may have changed
+        return nullptr; }  // the port cell itself needs no writeback
 
-    case SYM_INSERT:
+    case SYM_INSERT:  // a queue only accepts new events at its tail
     case SYM_APPEND:
+        if (not Is_Isotope(D_ARG(2)) and IS_BLOCK(D_ARG(2))) {
+            Enqueue_Event_Block(queue, D_ARG(2));  // batch of events
+            TRACE_EVENT(EVENT_TRACE_ENQUEUE, 0, Event_Queue_Length(queue));
+            return COPY(port);
+        }
+
         if (Is_Isotope(D_ARG(2)) or not IS_EVENT(D_ARG(2)))
             fail (D_ARG(2));
-        goto act_blk;
 
-    case SYM_PICK_P: {
-    act_blk:;
-        //
-        // !!! For performance, this reuses the same frame built for the
-        // INSERT/etc. on a PORT! to do an INSERT/etc. on whatever kind of
-        // value the state is.  It saves the value of the port, substitutes
-        // the state value in the first slot of the frame, and calls the
-        // array type dispatcher.  :-/
-        //
-        DECLARE_LOCAL (save_port);
-        Move_Cell(save_port, D_ARG(1));
-        Copy_Cell(D_ARG(1), state);
+        if (not Enqueue_Event(queue, D_ARG(2)))  // only refused if BLOCK
+            fail ("Event port queue is full (overflow policy is BLOCK)");
 
-        Bounce r = T_Array(frame_, verb);
+        TRACE_EVENT(EVENT_TRACE_ENQUEUE, 0, Event_Queue_Length(queue));
+        return COPY(port);
 
-        SET_SIGNAL(SIG_EVENT_PORT);
-        if (
-            ID_OF_SYMBOL(verb) == SYM_INSERT
-            || ID_OF_SYMBOL(verb) == SYM_APPEND
-            || ID_OF_SYMBOL(verb) == SYM_REMOVE
-        ){
-            return COPY(save_port);
+    case SYM_TAKE: {
+        INCLUDE_PARAMS_OF_TAKE;
+        UNUSED(PARAM(series));
+
+        if (REF(deep) or REF(last))
+            fail (Error_Bad_Refines_Raw());
+
+        if (REF(part)) {  // drain up to N events into a BLOCK!
+            if (not IS_INTEGER(ARG(part)) or VAL_INT64(ARG(part)) < 0)
+                fail (PARAM(part));
+
+            Init_Block(
+                OUT,
+                Dequeue_Events(queue, cast(REBLEN, VAL_INT64(ARG(part))))
+            );
+            TRACE_EVENT(EVENT_TRACE_DEQUEUE, 0, Event_Queue_Length(queue));
+            return OUT;
         }
-        return r; }
+
+        if (not Dequeue_Event(OUT, queue))
+            return nullptr;
+
+        TRACE_EVENT(EVENT_TRACE_DEQUEUE, 0, Event_Queue_Length(queue));
+        return OUT; }
+
+    case SYM_REMOVE: {
+        INCLUDE_PARAMS_OF_REMOVE;
+        UNUSED(PARAM(series));
+
+        REBI64 count = 1;
+        if (REF(part)) {
+            if (not IS_INTEGER(ARG(part)) or VAL_INT64(ARG(part)) < 0)
+                fail (PARAM(part));
+            count = VAL_INT64(ARG(part));
+        }
+
+        for (; count != 0; --count) {
+            if (not Dequeue_Event(SPARE, queue))
+                break;
+        }
+        TRACE_EVENT(EVENT_TRACE_DEQUEUE, 0, Event_Queue_Length(queue));
+        return COPY(port); }
 
     case SYM_CLEAR:
-        SET_SERIES_LEN(VAL_ARRAY_KNOWN_MUTABLE(state), 0);
+        Clear_Event_Queue(queue);
         CLR_SIGNAL(SIG_EVENT_PORT);
+        TRACE_EVENT(EVENT_TRACE_CLEAR, 0, 0);
         return COPY(port);
 
     case SYM_OPEN: {
@@ -145,13 +1355,51 @@ Bounce Event_Actor(Frame(*) frame_, REBVAL *port, Symbol(const*) verb)
         if (REF(new) or REF(read) or REF(write))
             fail (Error_Bad_Refines_Raw());
 
+        // A spec with a DELAY (as for the 'timer scheme) arms a timer that
+        // queues TIME events, once after DELAY and then every PERIOD if that
+        // is given.  Opening again re-arms it.
+        //
+        REBVAL *delay = rebValue("select", spec, "'delay");
+        if (delay) {
+            REBVAL *period = rebValue("select", spec, "'period");
+            int64_t delay_ns = Nanoseconds_From_Value(delay);
+            int64_t period_ns = 0;
+            if (period and not IS_BLANK(period))
+                period_ns = Nanoseconds_From_Value(period);
+            rebRelease(delay);
+            rebRelease(period);
+
+            if (delay_ns < 0 or period_ns < 0)
+                fail ("Timer DELAY and PERIOD can't be negative");
+
+            if (queue->timer) {
+                Disarm_Event_Timer(queue->timer);
+                queue->timer = nullptr;
+            }
+            queue->timer = Arm_Event_Timer(queue, delay_ns, period_ns);
+            if (queue->timer == nullptr)
+                fail ("Could not arm timer (timer ports need Linux timerfd)");
+        }
+
         return COPY(port); }
 
     case SYM_CLOSE: {
+        if (queue->timer) {
+            Disarm_Event_Timer(queue->timer);
+            queue->timer = nullptr;
+        }
+        Cancel_Event_Timeouts(queue);
+        if (queue->posts) {  // producers holding references keep it alive
+            Close_Event_Post_Queue(queue->posts);
+            queue->posts = nullptr;
+        }
         return COPY(port); }
 
-    case SYM_FIND:
-        break; // !!! R3-Alpha said "add it" (e.g. unimplemented)
+    case SYM_FIND:  // see FIND-EVENTS for a variant that returns all matches
+        if (Is_Isotope(D_ARG(2)))
+            fail (D_ARG(2));
+
+        return Find_Queued_Events(OUT, queue, D_ARG(2), false);
 
     default:
         break;
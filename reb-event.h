@@ -144,15 +144,70 @@ inline static void SET_VAL_EVENT_Y(REBVAL *v, uint16_t y) {
 #define SET_VAL_EVENT_KEYCODE(v,keycode) \
     SET_SECOND_UINT16(VAL_EVENT_DATA(v), (keycode))
 
+
+// Fill in every field of an event cell at once.  `node` must be null unless
+// the model is EVM_PORT or EVM_OBJECT, in which case it is the varlist.
+//
+inline static REBVAL *Init_Event(
+    REBVAL *out,
+    SymId type,
+    Byte flags,
+    Byte model,
+    Node* node,
+    uintptr_t data
+){
+    Reset_Unquoted_Header_Untracked(TRACK(out), CELL_MASK_EVENT);
+    INIT_VAL_NODE1(out, node);
+    SET_VAL_EVENT_TYPE(out, type);
+    mutable_VAL_EVENT_FLAGS(out) = flags;
+    mutable_VAL_EVENT_MODEL(out) = model;
+    VAL_EVENT_DATA(out) = data;
+    return out;
+}
+
+// Which of the 8 combinations of DOUBLE, CONTROL and SHIFT an event has, with
+// those as bits 2, 1 and 0.  That's also the order they are listed in FLAGS.
+//
+inline static REBLEN Event_Flag_Combo(noquote(Cell(const*)) v) {
+    Byte flags = VAL_EVENT_FLAGS(v);
+    return ((flags & EVF_DOUBLE) ? 4 : 0)
+        | ((flags & EVF_CONTROL) ? 2 : 0)
+        | ((flags & EVF_SHIFT) ? 1 : 0);
+}
+
 // !!! These hooks allow the REB_EVENT cell type to dispatch to code in the
 // EVENT! extension if it is loaded.
 //
+extern REBINT Cmp_Event(
+    noquote(Cell(const*)) t1,
+    noquote(Cell(const*)) t2,
+    bool strict
+);
+extern uint32_t Hash_Event(noquote(Cell(const*)) v, bool strict);
 extern REBINT CT_Event(noquote(Cell(const*)) a, noquote(Cell(const*)) b, bool strict);
 extern Bounce MAKE_Event(Frame(*) frame_, enum Reb_Kind kind, option(const REBVAL*) parent, const REBVAL *arg);
 extern Bounce TO_Event(Frame(*) frame_, enum Reb_Kind kind, const REBVAL *arg);
 extern void MF_Event(REB_MOLD *mo, noquote(Cell(const*)) v, bool form);
 extern REBTYPE(Event);
 
+// Field setters behind MAKE EVENT!, false if the value is the wrong type.
+//
+extern bool Set_Event_Type(REBVAL *event, const REBVAL *val);
+extern bool Set_Event_Eventee(REBVAL *event, const REBVAL *val);
+extern bool Set_Event_Offset(REBVAL *event, const REBVAL *val);
+extern bool Set_Event_Key(REBVAL *event, const REBVAL *val);
+extern bool Set_Event_Code(REBVAL *event, const REBVAL *val);
+extern bool Set_Event_Flags(REBVAL *event, const REBVAL *val);
+
+extern REBVAL *Get_Event_Var(  // nullptr if field is absent or unknown
+    Value(*) out,
+    noquote(Cell(const*)) v,
+    Symbol(const*) symbol
+);
+
+extern void Startup_Event_Flags(void);
+extern void Shutdown_Event_Flags(void);
+
 // !!! The port scheme is also being included in the extension.
 
 extern Bounce Event_Actor(Frame(*) frame_, REBVAL *port, Symbol(const*) verb);
@@ -160,4 +215,563 @@ extern void Startup_Event_Scheme(void);
 extern void Shutdown_Event_Scheme(void);
 
 
+//=//// EVENT PORT QUEUE //////////////////////////////////////////////////=//
+//
+// An event port's STATE is a BLOCK! of two cells: a HANDLE! to the port's
+// Event_Queue, and the eventee table of a RECORD-EVENTS in progress (BLANK!
+// if none), which is there so the GC marks it along with the port.  The
+// queued EVENT! cells live in a BLOCK! in the port's DATA field (so the GC
+// sees the eventees they reference).  That block is used as a ring: its length
+// is always the capacity (a power of 2), unused slots hold BLANK!, and the
+// event with sequence number `seq` sits at index `seq & (capacity - 1)`.
+//
+// Sequence numbers are 32-bit and allowed to wrap; only their differences
+// are meaningful.  Since they don't change when the ring is reallocated to
+// a larger capacity, growth just re-seats each live event by its sequence.
+//
+
+#define EVENTS_LIMIT 0xFFFF  // 64k, most events a port will hold at once
+#define EVENTS_CHUNK 128  // initial capacity of the ring
+
+// What Enqueue_Event() does when the queue is at its limit.  The names are
+// the WORD!s used by CONFIGURE-EVENT-PORT/OVERFLOW (see %p-event.c)
+//
+enum Reb_Event_Overflow {
+    EVQ_OVERFLOW_BLOCK,  // refuse the new event, so the producer must wait
+    EVQ_OVERFLOW_DROP_OLDEST,  // discard the head to make room
+    EVQ_OVERFLOW_DROP_NEWEST,  // discard the new event
+    EVQ_OVERFLOW_COALESCE,  // merge into tail if same source, else DROP_OLDEST
+    EVQ_OVERFLOW_MAX
+};
+
+// Each event type seen by a queue gets a chain linking its queued events in
+// order, so FIND by type walks only the matches.  The links are stored per
+// ring slot as the distance to the next sequence number of the same type.
+// If a queue sees more distinct types than there are chains, the extra
+// types go unindexed and FIND falls back to scanning for them.
+//
+#define EVENT_TYPE_CHAINS 64  // power of 2
+
+typedef struct {
+    uint16_t type;  // SymId, or SYM_0 if this chain is unused
+    uint32_t first;  // sequence number of the oldest event of this type
+    uint32_t last;  // sequence number of the newest event of this type
+    REBLEN count;
+} Event_Type_Chain;
+
+// Latency tracking (CONFIGURE-EVENT-PORT/LATENCY) keeps the monotonic time
+// each event was queued in a ring parallel to the cells, so the EVENT! cell
+// doesn't have to grow.  When an event is taken, its time in the queue is
+// counted in a histogram whose bucket `i` is [2^i, 2^(i+1)) microseconds
+// (bucket 0 also takes anything under a microsecond).
+//
+#define EVENT_LATENCY_BUCKETS 24  // last bucket is everything over ~8 sec
+
+typedef struct Reb_Event_Queue {
+    Context(*) port;  // port whose DATA holds the ring
+    uint32_t head;  // sequence number of the oldest queued event
+    uint32_t tail;  // sequence number the next enqueued event will get
+    REBLEN capacity;  // size of the ring, always a power of 2
+    REBLEN limit;  // queue is "full" at this many events
+
+    enum Reb_Event_Overflow overflow;
+    bool coalesce_motion;  // merge EVF_HAS_XY events into a matching tail
+    uint64_t refused;  // enqueues rejected under EVQ_OVERFLOW_BLOCK
+    uint64_t dropped;  // events discarded to stay within the limit
+    uint64_t coalesced;  // events merged into the event at the tail
+
+    int64_t *enqueued_at;  // per ring slot nanoseconds, null if not tracking
+    uint64_t latency_histogram[EVENT_LATENCY_BUCKETS];
+    int64_t max_latency;  // nanoseconds, longest an event was queued
+
+    uint32_t *next_of_type;  // per ring slot, 0 if last of its type
+    Event_Type_Chain chains[EVENT_TYPE_CHAINS];
+    bool unindexed;  // some types didn't get a chain
+
+    struct Reb_Event_Post_Queue *posts;  // for other threads, null if none
+    struct Reb_Event_Capture *capture;  // RECORD-EVENTS file, null if none
+    struct Reb_Event_Timer *timer;  // for 'timer scheme ports, else null
+    uint32_t timeouts;  // SET-TIMEOUT slot + 1 of first timeout, 0 if none
+
+    // Queues holding events are kept on a "ready list", so WAIT can find
+    // the ports with pending work without checking every port it waits on.
+    //
+    bool ready;  // on the ready list (i.e. not empty)
+    struct Reb_Event_Queue *prev_ready;
+    struct Reb_Event_Queue *next_ready;
+    uint32_t wait_id;  // stamped by the WAIT that is waiting on this port
+} Event_Queue;
+
+inline static REBLEN Event_Queue_Length(const Event_Queue *q)
+  { return cast(REBLEN, q->tail - q->head); }
+
+extern Event_Queue *Event_Queue_Of_Port(const REBVAL *port);
+extern bool Enqueue_Event(Event_Queue *q, const REBVAL *event);
+extern bool Dequeue_Event(Value(*) out, Event_Queue *q);
+extern void Clear_Event_Queue(Event_Queue *q);
+extern void Track_Event_Latency(Event_Queue *q, bool on);
+extern Cell(*) Event_Queue_At(Event_Queue *q, REBINT n);  // 0 is the head
+extern Cell(*) Event_Queue_Eventees(Event_Queue *q);  // slot in the STATE
+extern enum Reb_Event_Overflow Event_Overflow_From_Word(Cell(const*) word);
+extern REBVAL *Find_Queued_Events(
+    Value(*) out,
+    Event_Queue *q,
+    const REBVAL *pattern,
+    bool all
+);
+
+extern int64_t Nanoseconds_From_Value(Cell(const*) v);  // seconds or TIME!
+
+extern Event_Queue *Try_Event_Queue_Of_Port(const REBVAL *port);
+extern uint32_t Begin_Event_Wait(const REBVAL *ports, bool *wakes);
+extern int64_t Next_Event_Wait_Timeout(const REBVAL *ports);
+extern REBVAL *Ready_Event_Ports(Value(*) out, uint32_t wait_id, bool all);
+
+
+//=//// CLOCK ///////////////////////////////////////////////////////////////=//
+//
+// Monotonic_Nanoseconds() reads a clock which is not affected by changes to
+// the wall clock, so it is what deadlines should be computed against.  The
+// zero point is arbitrary (e.g. system boot), only differences are useful.
+//
+// Delta_Time() is the historical microsecond interface, kept for callers
+// that passed 0 to get a "counter" and later passed that back as the base.
+//
+// With the clock made virtual (see VIRTUAL-CLOCK), Monotonic_Nanoseconds()
+// and Delta_Time() read a counter that only moves when ADVANCE-CLOCK is
+// called, or when a WAIT with a timeout jumps it to the deadline instead of
+// sleeping.  Real_Monotonic_Nanoseconds() is the platform's clock either
+// way, for things like tracing that are about the real timeline.
+//
+
+extern int64_t Real_Monotonic_Nanoseconds(void);
+
+extern bool Clock_Is_Virtual;
+extern int64_t Virtual_Clock_Nanoseconds;
+
+inline static int64_t Monotonic_Nanoseconds(void) {
+    if (Clock_Is_Virtual)
+        return Virtual_Clock_Nanoseconds;
+    return Real_Monotonic_Nanoseconds();
+}
+
+inline static int64_t Delta_Nanoseconds(int64_t base)
+  { return Monotonic_Nanoseconds() - base; }
+
 extern int64_t Delta_Time(int64_t base);
+
+extern int64_t Process_Cpu_Nanoseconds(void);
+
+
+//=//// TIMEOUTS //////////////////////////////////////////////////////////=//
+//
+// SET-TIMEOUT schedules a TIME event for a port, on a hierarchical timing
+// wheel shared by all ports (%event-timeouts.c).  Setting and cancelling
+// are O(1), so a process can keep a timeout per connection and re-set it on
+// every read without WAIT having to scan anything.
+//
+// The wheel has EVENT_WHEEL_LEVELS levels of EVENT_WHEEL_BUCKETS buckets,
+// and a tick of EVENT_WHEEL_TICK nanoseconds.  Level 0 holds timeouts due
+// within 64 ticks, level 1 those within 64^2, etc.  When the wheel turns to
+// the start of a bucket in a level above 0, the timeouts in it are filed
+// again into the levels below.  Timeouts further out than the wheel spans
+// (about 4.6 hours) wait in the last bucket of the top level, and are filed
+// again each time it comes around.
+//
+// Timeouts fire from WAIT*, which runs the wheel up to the current time on
+// each round and doesn't sleep past the nearest one.  The event's CODE is
+// the id that SET-TIMEOUT returned.  Ids encode a slot and a 32-bit
+// generation, so cancelling a timeout that already fired (whose slot may
+// have been reused) is harmless.  (An id is up to 52 bits, so on 32-bit
+// platforms the event's CODE has only the low half of it.)
+//
+
+#define EVENT_WHEEL_TICK 1000000  // 1 millisecond
+#define EVENT_WHEEL_BUCKETS 64  // per level, bits of a uint64_t occupancy mask
+#define EVENT_WHEEL_LEVELS 4
+
+#define EVENT_TIMEOUTS_MAX (1 << 20)  // slot is the low 20 bits of an id
+
+extern uint64_t Set_Event_Timeout(  // id, or 0 if out of memory or slots
+    Event_Queue *q,
+    int64_t delay,  // nanoseconds until it fires
+    int64_t period  // nanoseconds between later firings, 0 for one-shot
+);
+extern bool Cancel_Event_Timeout(uint64_t id);  // false if not pending
+extern void Cancel_Event_Timeouts(Event_Queue *q);  // all of a port's
+extern REBLEN Run_Event_Timeouts(int64_t now);  // number fired
+extern int64_t Next_Event_Timeout(void);  // not after it, INT64_MAX if none
+extern int64_t Next_Event_Timeout_Of_Queue(Event_Queue *q);  // exact
+extern REBLEN Pending_Event_Timeouts(void);
+extern void Shutdown_Event_Timeouts(void);
+
+
+//=//// WAIT BACKEND and READINESS SOURCES ////////////////////////////////=//
+//
+// WAIT* alternates between polling devices and yielding to the OS.  On POSIX
+// anything with a file descriptor can register itself as a "readiness
+// source", and the yield ends as soon as one of those descriptors becomes
+// readable--instead of sleeping out the whole slice.  On Linux this is done
+// with epoll, otherwise it falls back to a select() over the registered
+// descriptors (which with no sources is the historical bare sleep).
+//
+// The source's callback runs on the interpreter thread, from inside WAIT*.
+// Readiness is level-triggered, so the callback must consume whatever made
+// the descriptor readable or it will be called again on the next yield.
+//
+
+typedef struct Reb_Event_Source Event_Source;
+
+typedef void (EVENT_SOURCE_CFUNC)(Event_Source *source);
+
+struct Reb_Event_Source {
+    int fd;
+    EVENT_SOURCE_CFUNC *on_ready;
+    void *context;  // for use by the callback
+    REBLEN index;  // in the registered list, kept by Register_Event_Source()
+};
+
+enum Reb_Wait_Result {
+    WAIT_TIMED_OUT,  // slept the full time
+    WAIT_INTERRUPTED,  // e.g. Ctrl-C signal, or a GUI message on Windows
+    WAIT_SOURCE_READY  // one or more registered sources ran their callbacks
+};
+
+extern void Startup_Events(void);
+extern void Shutdown_Events(void);
+
+extern enum Reb_Wait_Result Wait_Milliseconds_Interrupted(
+    unsigned int millisec
+);
+
+extern bool Register_Event_Source(Event_Source *source);
+extern void Unregister_Event_Source(Event_Source *source);
+extern bool Have_Event_Sources(void);
+extern bool Poll_Event_Sources(void);  // doesn't block, true if any ready
+
+// Timer ports (the 'timer scheme) are event ports with a kernel timer whose
+// expirations are a readiness source.  Each expiration queues a TIME event
+// whose CODE is how many times the timer expired since the last one, so a
+// consumer that falls behind a periodic timer can tell.  (Event types are
+// stored as SymIds, and the core has SYM_TIME but no SYM_TIMER.)  Returns
+// nullptr if the platform has no such timers (only Linux timerfd is done).
+//
+typedef struct Reb_Event_Timer Event_Timer;
+
+extern Event_Timer *Arm_Event_Timer(
+    Event_Queue *q,
+    int64_t delay,  // nanoseconds until the first expiration
+    int64_t period  // nanoseconds between later expirations, 0 for one-shot
+);
+extern void Disarm_Event_Timer(Event_Timer *timer);
+
+extern const char *Wait_Backend_Name(void);
+extern bool Use_Wait_Backend(const char *name);
+
+
+// A wakeup is a descriptor that any thread can make readable, so it can be
+// registered as a readiness source to interrupt WAIT.  On Linux it's an
+// eventfd, on other POSIX systems a non-blocking pipe.  Opening it fails on
+// Windows, where WAIT's message pump can't wait on descriptors.
+//
+typedef struct {
+    int read_fd;  // what gets registered as the readiness source
+    int write_fd;  // same as read_fd for an eventfd
+} Event_Wakeup;
+
+extern bool Open_Event_Wakeup(Event_Wakeup *w);
+extern void Signal_Event_Wakeup(Event_Wakeup *w);  // safe from any thread
+extern void Clear_Event_Wakeup(Event_Wakeup *w);
+extern void Close_Event_Wakeup(Event_Wakeup *w);
+
+
+//=//// ATOMICS ///////////////////////////////////////////////////////////=//
+//
+// The interpreter is single-threaded, but event ports accept events posted
+// from other threads (see Post_Event()).  Only the handful of word-sized
+// operations the lock-free post queue and trace ring need are provided.
+//
+
+#if defined(__GNUC__)  // includes clang
+
+    inline static uintptr_t Atomic_Load(uintptr_t *p)
+      { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+
+    inline static void Atomic_Store(uintptr_t *p, uintptr_t v)
+      { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+
+    inline static uintptr_t Atomic_Exchange(uintptr_t *p, uintptr_t v)
+      { return __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL); }
+
+    inline static uintptr_t Atomic_Fetch_Add(uintptr_t *p, uintptr_t n)
+      { return __atomic_fetch_add(p, n, __ATOMIC_ACQ_REL); }
+
+    inline static bool Atomic_Compare_Exchange(
+        uintptr_t *p,
+        uintptr_t *expected,  // updated with the current value on failure
+        uintptr_t desired
+    ){
+        return __atomic_compare_exchange_n(
+            p, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE
+        );
+    }
+
+#elif defined(_MSC_VER)
+
+    #include <intrin.h>
+
+    // MSVC gives volatile accesses acquire/release semantics (/volatile:ms)
+    //
+    inline static uintptr_t Atomic_Load(uintptr_t *p)
+      { return *cast(volatile uintptr_t*, p); }
+
+    inline static void Atomic_Store(uintptr_t *p, uintptr_t v)
+      { *cast(volatile uintptr_t*, p) = v; }
+
+    inline static uintptr_t Atomic_Exchange(uintptr_t *p, uintptr_t v) {
+        return cast(uintptr_t, _InterlockedExchangePointer(
+            cast(void* volatile*, p), cast(void*, v)
+        ));
+    }
+
+    inline static uintptr_t Atomic_Fetch_Add(uintptr_t *p, uintptr_t n) {
+      #if defined(_WIN64)
+        return cast(uintptr_t, _InterlockedExchangeAdd64(
+            cast(volatile __int64*, p), cast(__int64, n)
+        ));
+      #else
+        return cast(uintptr_t, _InterlockedExchangeAdd(
+            cast(volatile long*, p), cast(long, n)
+        ));
+      #endif
+    }
+
+    inline static bool Atomic_Compare_Exchange(
+        uintptr_t *p,
+        uintptr_t *expected,  // updated with the current value on failure
+        uintptr_t desired
+    ){
+        uintptr_t prior = cast(uintptr_t, _InterlockedCompareExchangePointer(
+            cast(void* volatile*, p), cast(void*, desired), cast(void*, *expected)
+        ));
+        if (prior == *expected)
+            return true;
+        *expected = prior;
+        return false;
+    }
+
+#else
+
+    // !!! No known atomics (e.g. TCC).  These are only correct if there is
+    // no posting from other threads, which is then unsupported.
+    //
+    inline static uintptr_t Atomic_Load(uintptr_t *p)
+      { return *p; }
+
+    inline static void Atomic_Store(uintptr_t *p, uintptr_t v)
+      { *p = v; }
+
+    inline static uintptr_t Atomic_Exchange(uintptr_t *p, uintptr_t v)
+      { uintptr_t prior = *p; *p = v; return prior; }
+
+    inline static uintptr_t Atomic_Fetch_Add(uintptr_t *p, uintptr_t n)
+      { uintptr_t prior = *p; *p += n; return prior; }
+
+    inline static bool Atomic_Compare_Exchange(
+        uintptr_t *p,
+        uintptr_t *expected,
+        uintptr_t desired
+    ){
+        if (*p != *expected) {
+            *expected = *p;
+            return false;
+        }
+        *p = desired;
+        return true;
+    }
+
+#endif
+
+
+//=//// POSTING EVENTS FROM OTHER THREADS /////////////////////////////////=//
+//
+// Native code doing I/O on its own threads can hand results to an event
+// port with Post_Event().  Each port has at most one post queue: a bounded
+// lock-free multi-producer, single-consumer ring of compact events.  The
+// interpreter thread is the only consumer.
+//
+// A post signals the queue's wakeup, which interrupts a blocked WAIT.  The
+// wakeup's callback then moves the posted events into the port's queue,
+// subject to the port's overflow policy.  Posted events are also moved
+// whenever the port itself is acted on.  Posted events get the port as
+// their eventee.
+//
+// The post queue pointer must only be obtained on the interpreter thread.
+// CLOSE (or garbage collection of the port) lets go of the post queue, and
+// from then on posts to it fail.  A producer thread which may outlive the
+// port has to take a reference with Retain_Event_Post_Queue() before it is
+// started, and give it up with Release_Event_Post_Queue() when done.
+//
+
+typedef struct {
+    uint16_t type;  // SymId
+    Byte flags;  // EVF_XXX
+    uintptr_t data;  // e.g. use SET_FIRST_UINT16() for X, SECOND for Y
+} Posted_Event;
+
+typedef struct Reb_Event_Post_Queue Event_Post_Queue;
+
+extern Event_Post_Queue *Event_Post_Queue_Of_Port(
+    const REBVAL *port,
+    REBLEN capacity  // rounded up to a power of 2, if newly created
+);
+
+extern bool Post_Event(  // safe from any thread, false if full or closed
+    Event_Post_Queue *pq,
+    const Posted_Event *event
+);
+
+extern void Retain_Event_Post_Queue(Event_Post_Queue *pq);
+extern void Release_Event_Post_Queue(Event_Post_Queue *pq);  // any thread
+
+extern bool Post_Event_Later(  // from a helper thread, for measuring wakeups
+    Event_Post_Queue *pq,
+    const Posted_Event *event,
+    unsigned int millisec
+);
+
+
+//=//// BINARY EVENT RECORDS and CAPTURE FILES ////////////////////////////=//
+//
+// An event's fixed-width binary form is a 24 byte record, little-endian:
+//
+//     0  uint64  nanoseconds since the start of the capture (0 if unused)
+//     8  uint16  type (SymId)
+//    10  uint8   flags (EVF_XXX)
+//    11  uint8   model (EVM_XXX)
+//    12  uint32  data (X or keysym in the low half, Y or keycode in high)
+//    16  uint32  eventee, as an index into a table kept alongside the file
+//    20  uint32  data's high 32 bits (only TIME events' CODE uses them)
+//
+// The high bits were a reserved field that was always 0, so older captures
+// read the same.  On 32-bit platforms they are dropped when decoding.
+//
+// Ports and objects can't be written to a file, so the eventee field refers
+// to a BLOCK! of them that RECORD-EVENTS gives back when it is stopped, and
+// that REPLAY-EVENTS can be handed.  EVENT_EVENTEE_NONE is for GUI events.
+//
+// A capture file is a 16 byte header followed by records:
+//
+//     0  "REVT"
+//     4  uint16  version (EVENT_CAPTURE_VERSION)
+//     6  uint16  record size (EVENT_RECORD_SIZE)
+//     8  uint32  number of records
+//    12  uint32  reserved, 0
+//
+
+#define EVENT_RECORD_SIZE 24
+#define EVENT_CAPTURE_HEADER_SIZE 16
+#define EVENT_CAPTURE_MAGIC "REVT"
+#define EVENT_CAPTURE_VERSION 1
+#define EVENT_EVENTEE_NONE 0xFFFFFFFF
+
+typedef struct Reb_Event_Capture Event_Capture;
+
+extern void Encode_Event_Record(
+    Byte *bp,
+    noquote(Cell(const*)) event,
+    int64_t time,
+    uint32_t eventee
+);
+extern REBVAL *Decode_Event_Record(
+    REBVAL *out,
+    const Byte *bp,
+    const REBVAL *eventees,  // BLOCK! the eventee indices refer to, or null
+    const REBVAL *port  // eventee if not in the table, or null to fail
+);
+extern int64_t Event_Record_Time(const Byte *bp);
+extern uint32_t Check_Event_Capture_Header(const Byte *bp, size_t size);
+
+extern REBVAL *Encode_Events(const REBVAL *events, REBVAL *eventees);
+
+extern Event_Capture *Start_Event_Capture(
+    const char *path,
+    uint32_t limit,
+    Array(*) eventees  // managed, and kept alive by the caller
+);
+extern void Capture_Event(Event_Capture *capture, const REBVAL *event);
+extern int Finish_Event_Capture(Event_Capture *capture);  // OS error, or 0
+extern void Free_Event_Capture(Event_Capture *capture);  // safe in GC sweep
+
+// Files are memory-mapped through these, implemented per platform.  Mapping
+// for writing creates (or truncates) the file at `size` bytes; mapping for
+// reading maps all of an existing file and sets `size`.  Unmapping a file
+// that was written truncates it to `keep` bytes.
+//
+typedef struct {
+    Byte *base;
+    size_t size;
+    intptr_t handle;  // file descriptor or HANDLE
+    bool writable;
+} Event_File_Mapping;
+
+extern bool Map_Event_File(
+    Event_File_Mapping *m,
+    const char *path,
+    size_t size,
+    bool writable
+);
+extern int Unmap_Event_File(  // OS error code if truncating failed, else 0
+    Event_File_Mapping *m,
+    size_t keep
+);
+
+
+//=//// TRACING ///////////////////////////////////////////////////////////=//
+//
+// Building with DEBUG_EVENT_TRACE=1 adds trace points to WAIT*, the event
+// port actor, and MAKE EVENT!.  Each writes a fixed-size record into one
+// lock-free ring per process (%event-trace.c), overwriting the oldest, and
+// DUMP-EVENT-TRACE renders the ring as Chrome `about://tracing` JSON.
+//
+// When it is 0 (the default) TRACE_EVENT() compiles to nothing, and the
+// TRACE_CLOCK() used to time a span is the constant 0.
+//
+
+#if !defined(DEBUG_EVENT_TRACE)
+    #define DEBUG_EVENT_TRACE 0
+#endif
+
+enum Reb_Event_Trace_Kind {
+    EVENT_TRACE_WAIT_ITERATION,  // arg is the wait_millisec for the round
+    EVENT_TRACE_POLL,  // span, arg is nonzero if there was activity
+    EVENT_TRACE_SLEEP,  // span, arg is the millisecond timeout
+    EVENT_TRACE_WAKE,  // arg is the enum Reb_Wait_Result
+    EVENT_TRACE_ENQUEUE,  // arg is the queue length afterward
+    EVENT_TRACE_DEQUEUE,  // arg is the queue length afterward
+    EVENT_TRACE_CLEAR,
+    EVENT_TRACE_MAKE,  // span
+    EVENT_TRACE_MAX
+};
+
+#if DEBUG_EVENT_TRACE
+    extern void Trace_Event(
+        enum Reb_Event_Trace_Kind kind,
+        int64_t start,  // from TRACE_CLOCK() for a span, 0 for an instant
+        uintptr_t arg
+    );
+    extern void Mold_Event_Trace(REB_MOLD *mo);
+    extern void Clear_Event_Trace(void);
+
+    #define TRACE_CLOCK() \
+        Real_Monotonic_Nanoseconds()
+
+    #define TRACE_EVENT(kind,start,arg) \
+        Trace_Event((kind), (start), cast(uintptr_t, (arg)))
+#else
+    #define TRACE_CLOCK() \
+        cast(int64_t, 0)
+
+    #define TRACE_EVENT(kind,start,arg) \
+        cast(void, (start))
+#endif
@@ -28,27 +28,72 @@
 #include "reb-event.h"
 
 
+// Flags that are part of an event's value when compared non-strictly.
+// EVF_COPIED only says how DROP-FILE's data is stored.
 //
-//  Cmp_Event: C
+#define EVF_MASK_COMPARED (EVF_HAS_XY | EVF_DOUBLE | EVF_CONTROL | EVF_SHIFT)
+
+
 //
-// Given two events, compare them.
+//  Event_Data_Compared: C
 //
-// !!! Like much of the comprarison code in R3-Alpha, this isn't very good.
-// It doesn't check key codes, doesn't check if EVF_HAS_XY but still compares
-// the x and y coordinates anyway...
+// The data bits only mean something for events with an offset, or for key
+// events.  Otherwise they may be left over from an unset OFFSET, so they
+// are only compared strictly.
 //
-REBINT Cmp_Event(noquote(Cell(const*)) t1, noquote(Cell(const*)) t2)
+static uintptr_t Event_Data_Compared(noquote(Cell(const*)) v, bool strict)
 {
-    REBINT  diff;
+    if (
+        strict
+        or (VAL_EVENT_FLAGS(v) & EVF_HAS_XY)
+        or VAL_EVENT_TYPE(v) == SYM_KEY
+        or VAL_EVENT_TYPE(v) == SYM_KEY_UP
+    ){
+        return VAL_EVENT_DATA(v);
+    }
+    return 0;
+}
+
+
+//
+//  Cmp_Event: C
+//
+// Given two events, compare them: model, type, eventee, flags, and then the
+// data (offset or key).  Eventees compare by identity, so the order between
+// events for different ports is consistent only within a session.
+//
+REBINT Cmp_Event(
+    noquote(Cell(const*)) t1,
+    noquote(Cell(const*)) t2,
+    bool strict
+){
+    REBINT diff;
 
     if (
            (diff = VAL_EVENT_MODEL(t1) - VAL_EVENT_MODEL(t2))
         || (diff = VAL_EVENT_TYPE(t1) - VAL_EVENT_TYPE(t2))
-        || (diff = VAL_EVENT_X(t1) - VAL_EVENT_X(t2))
-        || (diff = VAL_EVENT_Y(t1) - VAL_EVENT_Y(t2))
     ) return diff;
 
-    return 0;
+    if (VAL_EVENT_NODE(t1) != VAL_EVENT_NODE(t2))
+        return VAL_EVENT_NODE(t1) > VAL_EVENT_NODE(t2) ? 1 : -1;
+
+    Byte mask = strict ? 0xFF : EVF_MASK_COMPARED;
+    if ((diff = (VAL_EVENT_FLAGS(t1) & mask) - (VAL_EVENT_FLAGS(t2) & mask)))
+        return diff;
+
+    uintptr_t d1 = Event_Data_Compared(t1, strict);
+    uintptr_t d2 = Event_Data_Compared(t2, strict);
+    if (d1 == d2)
+        return 0;
+
+    // Compare the 16-bit halves (X then Y, or keysym then keycode) so the
+    // order doesn't depend on the platform's byte order.
+    //
+    if ((diff = FIRST_UINT16(d1) - FIRST_UINT16(d2)))
+        return diff;
+    if ((diff = SECOND_UINT16(d1) - SECOND_UINT16(d2)))
+        return diff;
+    return d1 > d2 ? 1 : -1;  // strict, and some other bits differ
 }
 
 
@@ -57,135 +102,221 @@ REBINT Cmp_Event(noquote(Cell(const*)) t1, noquote(Cell(const*)) t2)
 //
 REBINT CT_Event(noquote(Cell(const*)) a, noquote(Cell(const*)) b, bool strict)
 {
-    UNUSED(strict);
-    return Cmp_Event(a, b);
+    return Cmp_Event(a, b, strict);
+}
+
+
+//
+//  Hash_Event: C
+//
+// Hash of exactly what Cmp_Event() looks at, so events that compare equal
+// hash the same.
+//
+uint32_t Hash_Event(noquote(Cell(const*)) v, bool strict)
+{
+    Byte mask = strict ? 0xFF : EVF_MASK_COMPARED;
+
+    uint64_t h = VAL_EVENT_TYPE(v);
+    h = (h << 8) | VAL_EVENT_MODEL(v);
+    h = (h << 8) | (VAL_EVENT_FLAGS(v) & mask);
+    h ^= cast(uint64_t, cast(uintptr_t, VAL_EVENT_NODE(v))) * 0x9E3779B97F4A7C15;
+    h ^= cast(uint64_t, Event_Data_Compared(v, strict)) * 0xC2B2AE3D27D4EB4F;
+
+    h ^= h >> 33;  // finalizer from MurmurHash3's fmix64
+    h *= 0xFF51AFD7ED558CCD;
+    h ^= h >> 33;
+    return cast(uint32_t, h);
 }
 
 
 
 //
-//  Set_Event_Var: C
+//  Set_Event_Type: C
 //
-static bool Set_Event_Var(REBVAL *event, Cell(const*) word, const REBVAL *val)
+// The field setters are shared by MAKE EVENT! (via Set_Event_Var()) and by
+// INSTANTIATE-EVENT, which calls them directly on typechecked arguments.
+// Each returns false if the value isn't of a type the field takes.
+//
+bool Set_Event_Type(REBVAL *event, const REBVAL *val)
 {
-    switch (VAL_WORD_ID(word)) {
-      case SYM_TYPE: {
-        //
-        // !!! Rather limiting symbol-to-integer transformation for event
-        // type, based on R3-Alpha-era optimization ethos.
+    // !!! Rather limiting symbol-to-integer transformation for event
+    // type, based on R3-Alpha-era optimization ethos.
 
-        if (not IS_WORD(val))
-            return false;
+    if (not IS_WORD(val))
+        return false;
 
-        option(SymId) id = VAL_WORD_ID(val);
-        if (not id)  // !!! ...but for now, only symbols
-            fail ("EVENT! only takes types that are compile-time symbols");
+    option(SymId) id = VAL_WORD_ID(val);
+    if (not id)  // !!! ...but for now, only symbols
+        fail ("EVENT! only takes types that are compile-time symbols");
 
-        SET_VAL_EVENT_TYPE(event, unwrap(id));
-        return true; }
+    SET_VAL_EVENT_TYPE(event, unwrap(id));
+    return true;
+}
 
-      case SYM_PORT:
-        if (IS_PORT(val)) {
-            mutable_VAL_EVENT_MODEL(event) = EVM_PORT;
-            SET_VAL_EVENT_NODE(event, CTX_VARLIST(VAL_CONTEXT(val)));
-        }
-        else if (IS_OBJECT(val)) {
-            mutable_VAL_EVENT_MODEL(event) = EVM_OBJECT;
-            SET_VAL_EVENT_NODE(event, CTX_VARLIST(VAL_CONTEXT(val)));
-        }
-        else if (IS_BLANK(val)) {
-            mutable_VAL_EVENT_MODEL(event) = EVM_GUI;
-            SET_VAL_EVENT_NODE(event, nullptr);
-        }
-        else
-            return false;
-        break;
 
-      case SYM_WINDOW:
+//
+//  Set_Event_Eventee: C
+//
+bool Set_Event_Eventee(REBVAL *event, const REBVAL *val)
+{
+    if (IS_PORT(val)) {
+        mutable_VAL_EVENT_MODEL(event) = EVM_PORT;
+        SET_VAL_EVENT_NODE(event, CTX_VARLIST(VAL_CONTEXT(val)));
+    }
+    else if (IS_OBJECT(val)) {
+        mutable_VAL_EVENT_MODEL(event) = EVM_OBJECT;
+        SET_VAL_EVENT_NODE(event, CTX_VARLIST(VAL_CONTEXT(val)));
+    }
+    else if (IS_BLANK(val)) {
+        mutable_VAL_EVENT_MODEL(event) = EVM_GUI;
+        SET_VAL_EVENT_NODE(event, nullptr);
+    }
+    else
         return false;
 
-      case SYM_OFFSET:
-        if (Is_Nulled(val)) {  // use null to unset the coordinates
-            mutable_VAL_EVENT_FLAGS(event) &= ~EVF_HAS_XY;
-          #if !defined(NDEBUG)
-            SET_VAL_EVENT_X(event, 1020);
-            SET_VAL_EVENT_Y(event, 304);
-          #endif
-            return true;
-        }
+    return true;
+}
 
-        if (not IS_PAIR(val))  // historically seems to have only taken PAIR!
-            return false;
 
-        mutable_VAL_EVENT_FLAGS(event) |= EVF_HAS_XY;
-        SET_VAL_EVENT_X(event, VAL_PAIR_X_INT(val));
-        SET_VAL_EVENT_Y(event, VAL_PAIR_Y_INT(val));
+//
+//  Set_Event_Offset: C
+//
+bool Set_Event_Offset(REBVAL *event, const REBVAL *val)
+{
+    if (Is_Nulled(val)) {  // use null to unset the coordinates
+        mutable_VAL_EVENT_FLAGS(event) &= ~EVF_HAS_XY;
+      #if !defined(NDEBUG)
+        SET_VAL_EVENT_X(event, 1020);
+        SET_VAL_EVENT_Y(event, 304);
+      #endif
         return true;
+    }
 
-      case SYM_KEY:
-        mutable_VAL_EVENT_MODEL(event) = EVM_GUI;
-        if (IS_CHAR(val)) {
-            SET_VAL_EVENT_KEYCODE(event, VAL_CHAR(val));
-            SET_VAL_EVENT_KEYSYM(event, SYM_NONE);
-        }
-        else if (IS_WORD(val) or IS_QUOTED_WORD(val)) {
-            option(SymId) sym = VAL_WORD_ID(val);  // ...has to be symbol
-            if (not sym)
-                fail ("EVENT! only takes keys that are compile-time symbols");
-
-            SET_VAL_EVENT_KEYSYM(event, sym);
-            SET_VAL_EVENT_KEYCODE(event, 0);  // should this be set?
-            return true;
-        }
-        else
-            return false;
-        break;
+    if (not IS_PAIR(val))  // historically seems to have only taken PAIR!
+        return false;
 
-      case SYM_CODE:
-        if (IS_INTEGER(val)) {
-            VAL_EVENT_DATA(event) = VAL_INT32(val);
-        }
-        else
-            return false;
-        break;
+    mutable_VAL_EVENT_FLAGS(event) |= EVF_HAS_XY;
+    SET_VAL_EVENT_X(event, VAL_PAIR_X_INT(val));
+    SET_VAL_EVENT_Y(event, VAL_PAIR_Y_INT(val));
+    return true;
+}
 
-      case SYM_FLAGS: {
-        if (not IS_BLOCK(val))
+
+//
+//  Set_Event_Key: C
+//
+bool Set_Event_Key(REBVAL *event, const REBVAL *val)
+{
+    mutable_VAL_EVENT_MODEL(event) = EVM_GUI;
+    if (IS_CHAR(val)) {
+        SET_VAL_EVENT_KEYCODE(event, VAL_CHAR(val));
+        SET_VAL_EVENT_KEYSYM(event, SYM_NONE);
+        return true;
+    }
+
+    if (IS_WORD(val) or IS_QUOTED_WORD(val)) {
+        option(SymId) sym = VAL_WORD_ID(val);  // ...has to be symbol
+        if (not sym)
+            fail ("EVENT! only takes keys that are compile-time symbols");
+
+        SET_VAL_EVENT_KEYSYM(event, sym);
+        SET_VAL_EVENT_KEYCODE(event, 0);  // should this be set?
+        return true;
+    }
+
+    return false;
+}
+
+
+//
+//  Set_Event_Code: C
+//
+bool Set_Event_Code(REBVAL *event, const REBVAL *val)
+{
+    if (not IS_INTEGER(val))
+        return false;
+
+    if (VAL_EVENT_TYPE(event) == SYM_TIME) {  // all the data, see timers
+        REBI64 code = VAL_INT64(val);
+        if (code < 0 or cast(uint64_t, code) > UINTPTR_MAX)
             return false;
+        VAL_EVENT_DATA(event) = cast(uintptr_t, code);
+        return true;
+    }
+
+    VAL_EVENT_DATA(event) = VAL_INT32(val);
+    return true;
+}
 
-        mutable_VAL_EVENT_FLAGS(event)
-            &= ~(EVF_DOUBLE | EVF_CONTROL | EVF_SHIFT);
 
-        Cell(const*) tail;
-        Cell(const*) item = VAL_ARRAY_AT(&tail, val);
-        for (; item != tail; ++item) {
-            if (not IS_WORD(item))
-                continue;
+//
+//  Set_Event_Flags: C
+//
+bool Set_Event_Flags(REBVAL *event, const REBVAL *val)
+{
+    if (not IS_BLOCK(val))
+        return false;
+
+    mutable_VAL_EVENT_FLAGS(event)
+        &= ~(EVF_DOUBLE | EVF_CONTROL | EVF_SHIFT);
+
+    Cell(const*) tail;
+    Cell(const*) item = VAL_ARRAY_AT(&tail, val);
+    for (; item != tail; ++item) {
+        if (not IS_WORD(item))
+            continue;
 
-            switch (VAL_WORD_ID(item)) {
-            case SYM_CONTROL:
-                mutable_VAL_EVENT_FLAGS(event) |= EVF_CONTROL;
-                break;
+        switch (VAL_WORD_ID(item)) {
+        case SYM_CONTROL:
+            mutable_VAL_EVENT_FLAGS(event) |= EVF_CONTROL;
+            break;
 
-            case SYM_SHIFT:
-                mutable_VAL_EVENT_FLAGS(event) |= EVF_SHIFT;
-                break;
+        case SYM_SHIFT:
+            mutable_VAL_EVENT_FLAGS(event) |= EVF_SHIFT;
+            break;
 
-            case SYM_DOUBLE:
-                mutable_VAL_EVENT_FLAGS(event) |= EVF_DOUBLE;
-                break;
+        case SYM_DOUBLE:
+            mutable_VAL_EVENT_FLAGS(event) |= EVF_DOUBLE;
+            break;
 
-            default:
-                fail (Error_Bad_Value(item));
-            }
+        default:
+            fail (Error_Bad_Value(item));
         }
-        break; }
+    }
+    return true;
+}
+
+
+//
+//  Set_Event_Var: C
+//
+static bool Set_Event_Var(REBVAL *event, Cell(const*) word, const REBVAL *val)
+{
+    switch (VAL_WORD_ID(word)) {
+      case SYM_TYPE:
+        return Set_Event_Type(event, val);
+
+      case SYM_PORT:
+        return Set_Event_Eventee(event, val);
+
+      case SYM_WINDOW:
+        return false;
+
+      case SYM_OFFSET:
+        return Set_Event_Offset(event, val);
+
+      case SYM_KEY:
+        return Set_Event_Key(event, val);
+
+      case SYM_CODE:
+        return Set_Event_Code(event, val);
+
+      case SYM_FLAGS:
+        return Set_Event_Flags(event, val);
 
       default:
         return false;
     }
-
-    return true;
 }
 
 
@@ -251,12 +382,48 @@ void Set_Event_Vars(
 }
 
 
+// Reading FLAGS from an event gives one of these shared, frozen blocks
+// instead of making a new one each time.  Indexed by Event_Flag_Combo().
+//
+static REBVAL *Event_Flag_Blocks[8];
+
+
+//
+//  Startup_Event_Flags: C
+//
+void Startup_Event_Flags(void)
+{
+    REBLEN combo;
+    for (combo = 0; combo < 8; ++combo) {
+        Event_Flag_Blocks[combo] = rebValue("freeze reduce [",
+            (combo & 4) ? "'double" : "",
+            (combo & 2) ? "'control" : "",
+            (combo & 1) ? "'shift" : "",
+        "]");
+        rebUnmanage(Event_Flag_Blocks[combo]);
+    }
+}
+
+
+//
+//  Shutdown_Event_Flags: C
+//
+void Shutdown_Event_Flags(void)
+{
+    REBLEN combo;
+    for (combo = 0; combo < 8; ++combo) {
+        rebRelease(Event_Flag_Blocks[combo]);
+        Event_Flag_Blocks[combo] = nullptr;
+    }
+}
+
+
 //
 //  Get_Event_Var: C
 //
-// Will return BLANK! if the variable is not available.
+// Will return nullptr if the variable is not available.
 //
-static REBVAL *Get_Event_Var(
+REBVAL *Get_Event_Var(
     Value(*) out,
     noquote(Cell(const*)) v,
     Symbol(const*) symbol
@@ -303,26 +470,17 @@ static REBVAL *Get_Event_Var(
             fail (error);
         return out; }
 
-      case SYM_FLAGS:
-        if (
-            (VAL_EVENT_FLAGS(v) & (EVF_DOUBLE | EVF_CONTROL | EVF_SHIFT)) != 0
-        ){
-            Array(*) arr = Make_Array(3);
-
-            if (VAL_EVENT_FLAGS(v) & EVF_DOUBLE)
-                Init_Word(Alloc_Tail_Array(arr), Canon(DOUBLE));
-
-            if (VAL_EVENT_FLAGS(v) & EVF_CONTROL)
-                Init_Word(Alloc_Tail_Array(arr), Canon(CONTROL));
+      case SYM_FLAGS: {
+        REBLEN combo = Event_Flag_Combo(v);
+        if (combo == 0)
+            return nullptr;
 
-            if (VAL_EVENT_FLAGS(v) & EVF_SHIFT)
-                Init_Word(Alloc_Tail_Array(arr), Canon(SHIFT));
-
-            return Init_Block(out, arr);
-        }
-        return nullptr;
+        return Copy_Cell(out, Event_Flag_Blocks[combo]); }
 
       case SYM_CODE: {
+        if (VAL_EVENT_TYPE(v) == SYM_TIME)  // expirations, or a timeout's id
+            return Init_Integer(out, cast(REBI64, VAL_EVENT_DATA(v)));
+
         if (VAL_EVENT_TYPE(v) != SYM_KEY and VAL_EVENT_TYPE(v) != SYM_KEY_UP)
             return nullptr;
 
@@ -369,25 +527,32 @@ Bounce MAKE_Event(
     assert(kind == REB_EVENT);
     UNUSED(kind);
 
+    int64_t trace_start = TRACE_CLOCK();
+
     if (parent) {  // faster shorthand for COPY and EXTEND
         if (not IS_BLOCK(arg))
             fail (Error_Bad_Make(REB_EVENT, arg));
 
         Copy_Cell(OUT, unwrap(parent));  // !!! "shallow" event clone
         Set_Event_Vars(OUT, arg, VAL_SPECIFIER(arg));
+        TRACE_EVENT(EVENT_TRACE_MAKE, trace_start, 0);
         return OUT;
     }
 
     if (not IS_BLOCK(arg))
         fail (Error_Unexpected_Type(REB_EVENT, VAL_TYPE(arg)));
 
-    Reset_Unquoted_Header_Untracked(TRACK(OUT), CELL_MASK_EVENT);
-    INIT_VAL_NODE1(OUT, nullptr);
-    SET_VAL_EVENT_TYPE(OUT, SYM_NONE);  // SYM_0 shouldn't be used
-    mutable_VAL_EVENT_FLAGS(OUT) = EVF_MASK_NONE;
-    mutable_VAL_EVENT_MODEL(OUT) = EVM_PORT;  // ?
+    Init_Event(
+        OUT,
+        SYM_NONE,  // SYM_0 shouldn't be used
+        EVF_MASK_NONE,
+        EVM_PORT,  // ?
+        nullptr,
+        0
+    );
 
     Set_Event_Vars(OUT, arg, VAL_SPECIFIER(arg));
+    TRACE_EVENT(EVENT_TRACE_MAKE, trace_start, 0);
     return OUT;
 }
 
@@ -452,6 +617,37 @@ REBTYPE(Event)
 }
 
 
+//
+//  Mold_Event_Symbol_Field: C
+//
+static void Mold_Event_Symbol_Field(REB_MOLD *mo, const char *name, SymId id)
+{
+    New_Indented_Line(mo);
+    Append_Ascii(mo->series, name);
+    Append_Ascii(mo->series, ": '");
+
+    Symbol(const*) symbol = Canon_Symbol(id);
+    Append_Utf8(mo->series, STR_UTF8(symbol), STR_SIZE(symbol));
+}
+
+
+//
+//  Mold_Event_Value_Field: C
+//
+static void Mold_Event_Value_Field(
+    REB_MOLD *mo,
+    const char *name,
+    const REBVAL *value
+){
+    New_Indented_Line(mo);
+    Append_Ascii(mo->series, name);
+    Append_Ascii(mo->series, ": ");
+    if (IS_WORD(value))
+        Append_Codepoint(mo->series, '\'');
+    Mold_Value(mo, value);
+}
+
+
 //
 //  MF_Event: C
 //
@@ -459,32 +655,68 @@ void MF_Event(REB_MOLD *mo, noquote(Cell(const*)) v, bool form)
 {
     UNUSED(form);
 
-    REBLEN field;
-    option(SymId) fields[] = {
-        SYM_TYPE, SYM_PORT, SYM_OFFSET, SYM_KEY,
-        SYM_FLAGS, SYM_CODE, SYM_DATA, SYM_0
-    };
-
     Pre_Mold(mo, v);
     Append_Codepoint(mo->series, '[');
     mo->indent++;
 
-    DECLARE_LOCAL (var); // declare outside loop (has init code)
+    // Most fields are written straight from the cell's bits.  PORT and DATA
+    // hold a context or a string, and a TIME event's CODE may need 64 bits,
+    // so they go through Get_Event_Var() and the general molding.  The text
+    // is the same as if all fields did.
 
-    for (field = 0; fields[field] != 0; field++) {
-        if (not Get_Event_Var(var, v, Canon_Symbol(unwrap(fields[field]))))
-            continue;
+    SymId type = VAL_EVENT_TYPE(v);
+    bool is_key = (type == SYM_KEY or type == SYM_KEY_UP);
+
+    if (type != SYM_NONE)
+        Mold_Event_Symbol_Field(mo, "type", type);
 
+    DECLARE_LOCAL (var);
+    if (Get_Event_Var(var, v, Canon(PORT)))
+        Mold_Event_Value_Field(mo, "port", var);
+
+    if (VAL_EVENT_FLAGS(v) & EVF_HAS_XY) {
         New_Indented_Line(mo);
+        Append_Ascii(mo->series, "offset: ");
+        Append_Int(mo->series, VAL_EVENT_X(v));
+        Append_Codepoint(mo->series, 'x');
+        Append_Int(mo->series, VAL_EVENT_Y(v));
+    }
 
-        String(const*) canon = Canon_Symbol(unwrap(fields[field]));
-        Append_Utf8(mo->series, STR_UTF8(canon), STR_SIZE(canon));
-        Append_Ascii(mo->series, ": ");
-        if (IS_WORD(var))
-            Append_Codepoint(mo->series, '\'');
-        Mold_Value(mo, var);
+    if (is_key) {
+        if (VAL_EVENT_KEYSYM(v) != SYM_0)
+            Mold_Event_Symbol_Field(mo, "key", VAL_EVENT_KEYSYM(v));
+        else {
+            Context(*) error = Maybe_Init_Char(var, VAL_EVENT_KEYCODE(v));
+            if (error)
+                fail (error);
+            Mold_Event_Value_Field(mo, "key", var);
+        }
     }
 
+    REBLEN combo = Event_Flag_Combo(v);
+    if (combo != 0) {
+        New_Indented_Line(mo);
+        Append_Ascii(mo->series, "flags: [");
+        if (combo & 4)
+            Append_Ascii(mo->series, (combo & 3) ? "double " : "double");
+        if (combo & 2)
+            Append_Ascii(mo->series, (combo & 1) ? "control " : "control");
+        if (combo & 1)
+            Append_Ascii(mo->series, "shift");
+        Append_Codepoint(mo->series, ']');
+    }
+
+    if (is_key) {
+        New_Indented_Line(mo);
+        Append_Ascii(mo->series, "code: ");
+        Append_Int(mo->series, VAL_EVENT_KEYCODE(v));
+    }
+    else if (type == SYM_TIME and Get_Event_Var(var, v, Canon(CODE)))
+        Mold_Event_Value_Field(mo, "code", var);  // all of the data, 64-bit
+
+    if (type == SYM_DROP_FILE and Get_Event_Var(var, v, Canon(DATA)))
+        Mold_Event_Value_Field(mo, "data", var);
+
     mo->indent--;
     New_Indented_Line(mo);
     Append_Codepoint(mo->series, ']');